@@ -9,6 +9,7 @@
 #include <lv2/core/lv2.h>
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 // SUIL_LIB_IMPORT and SUIL_LIB_EXPORT mark the entry points of shared libraries
@@ -109,6 +110,23 @@ typedef void (*SuilTouchFunc)( //
 /// Initialization argument
 typedef enum { SUIL_ARG_NONE } SuilArg;
 
+/**
+   A UI type known to suil.
+
+   These correspond to the LV2 UI type URIs that suil can wrap, and can be
+   used to check for support without comparing URI strings.
+*/
+typedef enum {
+  SUIL_UI_TYPE_UNKNOWN, ///< Unknown UI type
+  SUIL_UI_TYPE_GTK2,    ///< Gtk2 widget (ui:GtkUI)
+  SUIL_UI_TYPE_GTK3,    ///< Gtk3 widget (ui:Gtk3UI)
+  SUIL_UI_TYPE_QT5,     ///< Qt5 widget (ui:Qt5UI)
+  SUIL_UI_TYPE_QT6,     ///< Qt6 widget (ui:Qt6UI)
+  SUIL_UI_TYPE_X11,     ///< X11 window (ui:X11UI)
+  SUIL_UI_TYPE_WINDOWS, ///< Windows window (ui:WindowsUI)
+  SUIL_UI_TYPE_COCOA,   ///< Cocoa view (ui:CocoaUI)
+} SuilUIType;
+
 /**
    Initialize suil.
 
@@ -139,6 +157,26 @@ SUIL_API unsigned
 suil_ui_supported(const char* SUIL_NONNULL host_type_uri,
                   const char* SUIL_NONNULL ui_type_uri);
 
+/**
+   Return the UI type for a UI type URI.
+
+   @return The type with the given URI, or #SUIL_UI_TYPE_UNKNOWN.
+*/
+SUIL_API SuilUIType
+suil_ui_type(const char* SUIL_NONNULL uri);
+
+/**
+   Check if suil can wrap a UI type, by type.
+
+   This is equivalent to suil_ui_supported(), but avoids looking up URIs so it
+   can be used for checking many UIs.  Unknown types are never supported.
+
+   @return 0 if wrapping is unsupported, otherwise the quality of the wrapping
+   as in suil_ui_supported().
+*/
+SUIL_API unsigned
+suil_ui_type_supported(SuilUIType host_type, SuilUIType ui_type);
+
 /**
    @}
    @defgroup suil_host Host
@@ -177,6 +215,241 @@ SUIL_API void
 suil_host_set_touch_func(SuilHost* SUIL_NONNULL      host,
                          SuilTouchFunc SUIL_NULLABLE touch_func);
 
+/**
+   Set the size of the port event queue for new instances.
+
+   If this is non-zero, every instance subsequently created by `host` has a
+   queue of at least `size` bytes that can be written to from another thread
+   with suil_instance_enqueue_port_event().  The default is zero, which
+   disables the queue.
+
+   Each event uses 16 bytes of overhead in addition to its payload.
+*/
+SUIL_API void
+suil_host_set_port_event_queue_size(SuilHost* SUIL_NONNULL host,
+                                    uint32_t               size);
+
+/**
+   Set whether new instances coalesce control port events.
+
+   If this is true, every instance subsequently created by `host` stores float
+   control values (with format 0 and a `buffer_size` of 4) instead of
+   delivering them to the UI immediately.  Only the latest value of each
+   changed port is then delivered by the next suil_instance_flush(), which
+   wrapped UIs call once per frame.  Other events, such as atoms, are still
+   delivered immediately and in order.
+
+   This greatly reduces the work done by the UI when the host sends many
+   control changes, for example while playing automation.  The default is
+   false, which delivers every event immediately.
+*/
+SUIL_API void
+suil_host_set_coalesce_controls(SuilHost* SUIL_NONNULL host, bool coalesce);
+
+/**
+   Set whether new instances coalesce control port writes from the UI.
+
+   If this is true, every instance subsequently created by `host` stores float
+   control writes from the UI (with protocol 0 and a `buffer_size` of 4)
+   instead of passing them to the host's write function immediately.  Only
+   the latest value of each changed port is then written by the next
+   suil_instance_flush(), so the host receives a bounded number of writes per
+   UI frame, for example while the user drags a knob.  Other writes, such as
+   atoms, and touch notifications are passed immediately and in order, after
+   any pending control writes.  Pending writes are also passed when the
+   instance is freed.  This has no effect if the host has no write function.
+
+   The default is false, which passes every write immediately.
+*/
+SUIL_API void
+suil_host_set_coalesce_writes(SuilHost* SUIL_NONNULL host, bool coalesce);
+
+/**
+   Set the frame rate of the scheduler that runs wrapped UIs.
+
+   Wrappers don't run a timer for every UI, instead all the UIs of a host are
+   idled (and flushed) by a single timer which runs at this rate.  Each UI
+   runs every few frames, as close as possible to its `ui:updateRate` option,
+   and UIs with the same rate always run in the same frame.  No UI runs faster
+   than the frame rate, so hosts with UIs that need to update faster, such as
+   meters on high refresh rate displays, should increase it.
+
+   This should be set before any instances are created.  The default is 60
+   frames per second.
+*/
+SUIL_API void
+suil_host_set_frame_rate(SuilHost* SUIL_NONNULL host, uint32_t rate);
+
+/**
+   Set whether wrappers idle UIs on the frame clock of their window.
+
+   If this is true, then wrappers that support it (currently only X11 in Gtk3)
+   idle each UI from the update phase of the toolkit's frame clock, rather
+   than from the scheduler's timer.  UI updates are then synchronised with
+   the display's refresh, and need no extra wakeups.  While a UI is unmapped
+   and its frame clock is stopped, it is idled from the scheduler at the
+   hidden rate instead.  Each UI still runs at most at its `ui:updateRate`.
+
+   This should be set before any instances are created.  The default is
+   false, which uses the scheduler for every UI.
+*/
+SUIL_API void
+suil_host_set_frame_clock_idle(SuilHost* SUIL_NONNULL host, bool frame_clock);
+
+/**
+   Cache statistics for a host.
+
+   A host caches the libraries it loads, so these counters show how often
+   loading was avoided by reusing something that was already loaded.
+*/
+typedef struct {
+  uint32_t module_hits;       ///< Wrapper module loads avoided
+  uint32_t module_misses;     ///< Wrapper modules loaded
+  uint32_t library_hits;      ///< UI library loads avoided
+  uint32_t library_misses;    ///< UI libraries loaded
+  uint32_t descriptor_hits;   ///< UI descriptors found in an existing index
+  uint32_t descriptor_misses; ///< UI descriptor searches that weren't hits
+} SuilCacheStats;
+
+/**
+   Get the cache statistics for a host.
+
+   This locks the host, so it is safe to call while UIs are loaded
+   asynchronously.
+*/
+SUIL_API SuilCacheStats
+suil_host_get_cache_stats(SuilHost* SUIL_NONNULL host);
+
+/// Function called for each UI in a library
+typedef void (*SuilUIFunc)( //
+  void* SUIL_UNSPECIFIED   data,
+  const char* SUIL_NONNULL ui_uri);
+
+/**
+   List the UIs in a UI library.
+
+   The library is loaded if necessary, and `func` is called with the URI of
+   every UI it contains, in the order the library returns them.  Loaded
+   libraries are cached by the host, so this is cheap for libraries that are
+   already in use by an instance.
+
+   @param host Host descriptor.
+   @param ui_binary_path Path of the UI binary.
+   @param func Function to call for each UI.
+   @param data Opaque user data passed to `func`.
+   @return Zero on success, or non-zero if the library could not be loaded.
+*/
+SUIL_API int
+suil_library_list_uis(SuilHost* SUIL_NONNULL   host,
+                      const char* SUIL_NONNULL ui_binary_path,
+                      SuilUIFunc SUIL_NONNULL  func,
+                      void* SUIL_UNSPECIFIED   data);
+
+/**
+   Times spent in each phase of the life of an instance.
+
+   All times are in nanoseconds, measured with a monotonic clock.  A time is
+   zero if its phase didn't happen, for example if the UI isn't wrapped.
+*/
+typedef struct {
+  uint64_t load_time;         ///< Loading the UI library (if not cached)
+  uint64_t lookup_time;       ///< Finding the UI descriptor in the library
+  uint64_t features_time;     ///< Building the feature array
+  uint64_t open_wrapper_time; ///< Loading the wrapper module (if not cached)
+  uint64_t instantiate_time;  ///< Calling instantiate() of the UI
+  uint64_t wrap_time;         ///< Wrapping the UI widget
+  uint64_t wrapper_free_time; ///< Destroying the wrapper
+  uint64_t cleanup_time;      ///< Calling cleanup() of the UI
+  uint64_t unload_time;       ///< Dropping (and maybe closing) libraries
+} SuilInstanceStats;
+
+/**
+   Function called with the final times of an instance when it is freed.
+
+   @param data Opaque user data passed to suil_host_set_stats_func().
+   @param controller The controller passed when creating the instance.
+   @param stats The times of every phase, including those of freeing.
+*/
+typedef void (*SuilInstanceStatsFunc)( //
+  void* SUIL_UNSPECIFIED                data,
+  SuilController                        controller,
+  const SuilInstanceStats* SUIL_NONNULL stats);
+
+/**
+   Set a function to be called with the times of every freed instance.
+
+   This is called at the end of suil_instance_free() for every instance
+   subsequently created by `host`, including those freed because creating
+   them failed, so slow UIs can be found in telemetry.
+*/
+SUIL_API void
+suil_host_set_stats_func(SuilHost* SUIL_NONNULL              host,
+                         SuilInstanceStatsFunc SUIL_NULLABLE stats_func,
+                         void* SUIL_UNSPECIFIED              stats_data);
+
+/**
+   Times spent idling a wrapped UI.
+
+   Each idle includes flushing pending events and calling the UI's idle
+   interface.  Times are in nanoseconds.
+*/
+typedef struct {
+  uint64_t average_time; ///< Moving average of idle times
+  uint64_t max_time;     ///< Longest idle time
+  uint32_t throttle;     ///< Factor the update rate is divided by (at least 1)
+} SuilIdleStats;
+
+/**
+   Function called when a wrapped UI is throttled or recovers.
+
+   @param data Opaque user data passed to suil_host_set_idle_budget().
+   @param controller The controller passed when creating the instance.
+   @param stats The idle times and current throttle factor of the UI.
+*/
+typedef void (*SuilIdleWatchdogFunc)( //
+  void* SUIL_UNSPECIFIED            data,
+  SuilController                    controller,
+  const SuilIdleStats* SUIL_NONNULL stats);
+
+/**
+   Set a time budget for idling each wrapped UI.
+
+   Every idle of a wrapped UI is timed.  When the moving average of a UI goes
+   over `budget` nanoseconds, its update rate is halved, and halved again if
+   it stays over budget.  When its average drops below half of the budget,
+   its update rate is doubled, until it is back to normal.  This prevents a
+   slow UI from stalling every other UI and the host.
+
+   The `watchdog_func` is called whenever the throttle factor of a UI
+   changes, so the host can tell the user that a UI is slow.
+
+   This should be set before any instances are created.  The default budget
+   is zero, which disables throttling.
+*/
+SUIL_API void
+suil_host_set_idle_budget(SuilHost* SUIL_NONNULL             host,
+                          uint64_t                           budget,
+                          SuilIdleWatchdogFunc SUIL_NULLABLE watchdog_func,
+                          void* SUIL_UNSPECIFIED             watchdog_data);
+
+/**
+   Load the wrapper modules for a container type in the background.
+
+   This starts loading every module that can wrap a UI in a widget of the
+   given type, which stay loaded for as long as the host exists.  Later calls
+   to suil_instance_new() use the already loaded modules, so opening the first
+   wrapped UI is as fast as opening any other.  This is typically called once
+   at startup, with the type of widget the host uses.
+
+   @param host Host descriptor.
+   @param container_type_uri URI of the host container widget type.
+   @return Zero on success, or non-zero if the type is unknown or loading
+   couldn't be started.
+*/
+SUIL_API int
+suil_host_preload(SuilHost* SUIL_NONNULL   host,
+                  const char* SUIL_NONNULL container_type_uri);
+
 /**
    Free `host`.
 */
@@ -187,6 +460,78 @@ suil_host_free(SuilHost* SUIL_NULLABLE host);
    @}
 */
 
+/**
+   @defgroup suil_buffer Buffer
+   @{
+*/
+
+/**
+   A reference-counted buffer for large port events.
+
+   A buffer can be passed to the UI with suil_instance_enqueue_buffer_event(),
+   which only passes a reference, so large payloads like spectra or waveforms
+   can be sent from the audio thread to the UI without copying.
+*/
+typedef struct SuilBufferImpl SuilBuffer;
+
+/**
+   Function called when the last reference to a buffer is dropped.
+
+   This is called from whichever thread dropped the last reference, which for
+   buffers passed to the UI is usually the UI thread.  The buffer is no longer
+   in use, so it may be filled and reused after taking a new reference with
+   suil_buffer_ref(), or freed with suil_buffer_free().
+*/
+typedef void (*SuilBufferReleaseFunc)( //
+  void* SUIL_UNSPECIFIED   data,
+  SuilBuffer* SUIL_NONNULL buffer);
+
+/**
+   Allocate a new buffer.
+
+   The returned buffer has a single reference owned by the caller.  This
+   allocates, so it shouldn't be called from a real-time thread.
+
+   @param size Size of the buffer data in bytes.
+   @param release_func Function called when the last reference is dropped, or
+   null to free the buffer then.
+   @param release_data Opaque user data passed to `release_func`.
+*/
+SUIL_API SuilBuffer* SUIL_ALLOCATED
+suil_buffer_new(uint32_t                            size,
+                SuilBufferReleaseFunc SUIL_NULLABLE release_func,
+                void* SUIL_UNSPECIFIED              release_data);
+
+/// Return a pointer to the data of a buffer, which is aligned to 16 bytes
+SUIL_API void* SUIL_NONNULL
+suil_buffer_get_data(SuilBuffer* SUIL_NONNULL buffer);
+
+/// Return the size of the data of a buffer in bytes
+SUIL_API uint32_t
+suil_buffer_get_size(const SuilBuffer* SUIL_NONNULL buffer);
+
+/// Take a new reference to a buffer, which is wait-free
+SUIL_API void
+suil_buffer_ref(SuilBuffer* SUIL_NONNULL buffer);
+
+/// Drop a reference to a buffer, and release it if it was the last
+SUIL_API void
+suil_buffer_unref(SuilBuffer* SUIL_NULLABLE buffer);
+
+/**
+   Free a buffer immediately.
+
+   This is only for buffers with a release function, which may free them when
+   they are released.  Otherwise, buffers are freed when their last reference
+   is dropped.
+*/
+SUIL_API void
+suil_buffer_free(SuilBuffer* SUIL_NULLABLE buffer);
+
+/**
+   @}
+*/
+
 /**
    @defgroup suil_instance Instance
    @{
@@ -237,6 +582,65 @@ suil_instance_new(SuilHost* SUIL_NONNULL    host,
                   const LV2_Feature* SUIL_NULLABLE const* SUIL_NULLABLE
                     features);
 
+/// A request to create an instance in the background
+typedef struct SuilInstanceRequestImpl SuilInstanceRequest;
+
+/**
+   Function called when a request to create an instance is ready.
+
+   This is called from the loader thread of the host, so it typically only
+   arranges for suil_instance_new_finish() to be called on the UI thread, for
+   example with g_idle_add() or QMetaObject::invokeMethod().  It must not call
+   suil_instance_new_finish() itself, and should return quickly, since other
+   requests wait for it.
+*/
+typedef void (*SuilInstanceReadyFunc)( //
+  void* SUIL_UNSPECIFIED            data,
+  SuilInstanceRequest* SUIL_NONNULL request);
+
+/**
+   Start creating a UI instance in the background.
+
+   This is like suil_instance_new(), but loads the UI library and finds the
+   descriptor (along with any wrapper module) in a background thread, since
+   that can be slow.  Each host has a single loader thread, which handles
+   requests in the order they were made.  When a request has been loaded,
+   `ready_func` is called, after which suil_instance_new_finish() must be
+   called on the UI thread to get the new instance.  This makes it possible to
+   open many UIs without blocking the UI thread.
+
+   The host and the data of the features must remain valid until the request
+   is finished, but the strings and the feature array itself are copied.
+
+   @return A request which must be passed to suil_instance_new_finish() exactly
+   once, or null if the request couldn't be started.
+*/
+SUIL_API SuilInstanceRequest* SUIL_ALLOCATED
+suil_instance_new_async(SuilHost* SUIL_NONNULL             host,
+                        SuilController                     controller,
+                        const char* SUIL_NULLABLE          container_type_uri,
+                        const char* SUIL_NONNULL           plugin_uri,
+                        const char* SUIL_NONNULL           ui_uri,
+                        const char* SUIL_NONNULL           ui_type_uri,
+                        const char* SUIL_NONNULL           ui_bundle_path,
+                        const char* SUIL_NONNULL           ui_binary_path,
+                        const LV2_Feature* SUIL_NULLABLE const* SUIL_NULLABLE
+                          features,
+                        SuilInstanceReadyFunc SUIL_NONNULL ready_func,
+                        void* SUIL_UNSPECIFIED             ready_data);
+
+/**
+   Finish creating a UI instance in the background.
+
+   This must be called on the UI thread, after the request's ready function
+   has been called.  It instantiates the UI and wraps it if necessary, and
+   frees `request`.
+
+   @return A new UI instance, or NULL if instantiation failed.
+*/
+SUIL_API SuilInstance* SUIL_ALLOCATED
+suil_instance_new_finish(SuilInstanceRequest* SUIL_NONNULL request);
+
 /**
    Free a plugin UI instance.
 
@@ -246,6 +650,15 @@ suil_instance_new(SuilHost* SUIL_NONNULL    host,
 SUIL_API void
 suil_instance_free(SuilInstance* SUIL_NULLABLE instance);
 
+/**
+   Get the times spent creating a UI instance.
+
+   The times of freeing the instance are zero, see suil_host_set_stats_func()
+   to get them.
+*/
+SUIL_API SuilInstanceStats
+suil_instance_get_stats(const SuilInstance* SUIL_NONNULL instance);
+
 /**
    Get the handle for a UI instance.
 
@@ -293,6 +706,98 @@ suil_instance_port_event(SuilInstance* SUIL_NONNULL   instance,
                          uint32_t                     format,
                          const void* SUIL_UNSPECIFIED buffer);
 
+/**
+   A change in a plugin port.
+
+   This holds the parameters of suil_instance_port_event(), so that many
+   events can be delivered at once with suil_instance_port_events().
+*/
+typedef struct {
+  uint32_t                     port_index;  ///< Index of the changed port
+  uint32_t                     buffer_size; ///< Size of `buffer` in bytes
+  uint32_t                     format;      ///< Format of `buffer`
+  const void* SUIL_UNSPECIFIED buffer;      ///< Change data
+} SuilPortEvent;
+
+/**
+   Notify the UI about several changes in plugin ports.
+
+   This is equivalent to calling suil_instance_port_event() for each event in
+   order, but is cheaper for delivering many events at once, for example to
+   update all of the meters in a UI every frame.
+
+   @param instance UI instance.
+   @param events Array of events to deliver in order.
+   @param n_events Number of elements in `events`.
+*/
+SUIL_API void
+suil_instance_port_events(SuilInstance* SUIL_NONNULL            instance,
+                          const SuilPortEvent* SUIL_UNSPECIFIED events,
+                          size_t                                n_events);
+
+/**
+   Queue a change in a plugin port to be delivered to the UI later.
+
+   This is like suil_instance_port_event(), except it may be called from a
+   thread other than the UI thread, such as the audio thread.  It is
+   wait-free, doesn't allocate, and copies `buffer`, so it is real-time safe.
+   At most one thread may write to a given instance at once.
+
+   Queued events are delivered to the UI in order by suil_instance_flush(),
+   which wrapped UIs call automatically before every idle callback.  The
+   queue must be enabled with suil_host_set_port_event_queue_size() before
+   the instance is created.
+
+   @param instance UI instance.
+   @param port_index Index of the port which has changed.
+   @param buffer_size Size of `buffer` in bytes.
+   @param format Format of `buffer` (mapped URI, or 0 for float).
+   @param buffer Change data, e.g. the new port value.
+   @return Zero on success, or non-zero if the queue is full or disabled.
+*/
+SUIL_API int
+suil_instance_enqueue_port_event(SuilInstance* SUIL_NONNULL   instance,
+                                 uint32_t                     port_index,
+                                 uint32_t                     buffer_size,
+                                 uint32_t                     format,
+                                 const void* SUIL_UNSPECIFIED buffer);
+
+/**
+   Queue a change in a plugin port with a payload in a shared buffer.
+
+   This is like suil_instance_enqueue_port_event(), except the payload isn't
+   copied.  Instead, a reference to `buffer` is queued, and the UI receives a
+   pointer to the buffer data when the event is delivered, after which the
+   reference is dropped.  The caller must not modify the buffer until it has
+   been released.
+
+   @param instance UI instance.
+   @param port_index Index of the port which has changed.
+   @param buffer_size Size of the event at the start of `buffer` in bytes.
+   @param format Format of the event (mapped URI).
+   @param buffer Buffer that contains the event.
+   @return Zero on success, or non-zero if the queue is full or disabled.
+*/
+SUIL_API int
+suil_instance_enqueue_buffer_event(SuilInstance* SUIL_NONNULL instance,
+                                   uint32_t                   port_index,
+                                   uint32_t                   buffer_size,
+                                   uint32_t                   format,
+                                   SuilBuffer* SUIL_NONNULL   buffer);
+
+/**
+   Deliver any pending port events to the UI.
+
+   This must be called from the UI thread.  Wrapped UIs are flushed
+   automatically, but hosts that embed a UI natively must call this regularly
+   (typically once per frame) to deliver events queued with
+   suil_instance_enqueue_port_event(), and the latest values of coalesced
+   controls (see suil_host_set_coalesce_controls()).  This also passes any
+   coalesced UI writes to the host (see suil_host_set_coalesce_writes()).
+*/
+SUIL_API void
+suil_instance_flush(SuilInstance* SUIL_NONNULL instance);
+
 /// Return a data structure defined by some LV2 extension URI
 SUIL_API const void* SUIL_UNSPECIFIED
 suil_instance_extension_data(SuilInstance* SUIL_NONNULL instance,
@@ -0,0 +1,71 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#ifndef SUIL_ATOMIC_H
+#define SUIL_ATOMIC_H
+
+#include <stdint.h>
+
+#ifdef _MSC_VER
+
+#  include <intrin.h>
+
+static inline uint32_t
+suil_atomic_load(const uint32_t* const ptr)
+{
+  return (uint32_t)_InterlockedOr((volatile long*)ptr, 0);
+}
+
+static inline void
+suil_atomic_store(uint32_t* const ptr, const uint32_t value)
+{
+  _InterlockedExchange((volatile long*)ptr, (long)value);
+}
+
+static inline uint32_t
+suil_atomic_add(uint32_t* const ptr, const uint32_t value)
+{
+  return (uint32_t)_InterlockedExchangeAdd((volatile long*)ptr, (long)value) +
+         value;
+}
+
+static inline uint32_t
+suil_atomic_sub(uint32_t* const ptr, const uint32_t value)
+{
+  return (uint32_t)_InterlockedExchangeAdd((volatile long*)ptr, -(long)value) -
+         value;
+}
+
+#else
+
+/// Load a value, with acquire semantics
+static inline uint32_t
+suil_atomic_load(const uint32_t* const ptr)
+{
+  return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+/// Store a value, with release semantics
+static inline void
+suil_atomic_store(uint32_t* const ptr, const uint32_t value)
+{
+  __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+/// Add to a value and return the result
+static inline uint32_t
+suil_atomic_add(uint32_t* const ptr, const uint32_t value)
+{
+  return __atomic_add_fetch(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+/// Subtract from a value and return the result
+static inline uint32_t
+suil_atomic_sub(uint32_t* const ptr, const uint32_t value)
+{
+  return __atomic_sub_fetch(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+#endif
+
+#endif // SUIL_ATOMIC_H
@@ -0,0 +1,67 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#include "atomic.h"
+#include "suil_internal.h"
+
+#include <suil/suil.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/// Offset of the data from the start of a buffer, aligned for any atom
+#define SUIL_BUFFER_DATA_OFFSET ((sizeof(SuilBuffer) + 15U) & ~(size_t)15U)
+
+SUIL_API SuilBuffer*
+suil_buffer_new(const uint32_t              size,
+                const SuilBufferReleaseFunc release_func,
+                void* const                 release_data)
+{
+  SuilBuffer* const buffer =
+    (SuilBuffer*)calloc(1, SUIL_BUFFER_DATA_OFFSET + size);
+
+  if (buffer) {
+    buffer->release_func = release_func;
+    buffer->release_data = release_data;
+    buffer->size         = size;
+    buffer->refs         = 1U;
+  }
+
+  return buffer;
+}
+
+SUIL_API void*
+suil_buffer_get_data(SuilBuffer* const buffer)
+{
+  return (char*)buffer + SUIL_BUFFER_DATA_OFFSET;
+}
+
+SUIL_API uint32_t
+suil_buffer_get_size(const SuilBuffer* const buffer)
+{
+  return buffer->size;
+}
+
+SUIL_API void
+suil_buffer_ref(SuilBuffer* const buffer)
+{
+  suil_atomic_add(&buffer->refs, 1U);
+}
+
+SUIL_API void
+suil_buffer_unref(SuilBuffer* const buffer)
+{
+  if (buffer && !suil_atomic_sub(&buffer->refs, 1U)) {
+    if (buffer->release_func) {
+      buffer->release_func(buffer->release_data, buffer);
+    } else {
+      free(buffer);
+    }
+  }
+}
+
+SUIL_API void
+suil_buffer_free(SuilBuffer* const buffer)
+{
+  free(buffer);
+}
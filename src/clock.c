@@ -0,0 +1,35 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#define _POSIX_C_SOURCE 200809L // for clock_gettime
+
+#include "suil_internal.h"
+
+#include <stdint.h>
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <time.h>
+#endif
+
+uint64_t
+suil_clock_now(void)
+{
+#ifdef _WIN32
+  LARGE_INTEGER frequency;
+  LARGE_INTEGER count;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&count);
+
+  const uint64_t f = (uint64_t)frequency.QuadPart;
+  const uint64_t c = (uint64_t)count.QuadPart;
+
+  return ((c / f) * 1000000000U) + (((c % f) * 1000000000U) / f);
+#else
+  struct timespec ts = {0, 0};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ((uint64_t)ts.tv_sec * 1000000000U) + (uint64_t)ts.tv_nsec;
+#endif
+}
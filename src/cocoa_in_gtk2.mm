@@ -2,19 +2,16 @@
 // Copyright 2014 Robin Gareus <robin@gareus.org>
 // SPDX-License-Identifier: ISC
 
+#include "glib_timer.h"
+#include "scheduler.h"
 #include "suil_internal.h"
 #include "warnings.h"
 
-#include <lv2/options/options.h>
-#include <lv2/urid/urid.h>
-
 SUIL_DISABLE_GTK_WARNINGS
 #include <gdk/gdkquartz.h>
 #include <gtk/gtk.h>
 SUIL_RESTORE_WARNINGS
 
-#include <string.h>
-
 #ifndef MAC_OS_X_VERSION_10_12
 #  define MAC_OS_X_VERSION_10_12 101200
 #endif
@@ -55,8 +52,8 @@ struct _SuilCocoaWrapper {
   int        alo_height;
 
   const LV2UI_Idle_Interface* idle_iface;
-  guint                       idle_id;
-  guint                       idle_ms;
+  SuilFrameEntry              frame;
+  float                       update_rate;
 };
 
 struct _SuilCocoaWrapperClass {
@@ -73,6 +70,7 @@ suil_cocoa_wrapper_finalize(GObject* gobject)
 {
   SuilCocoaWrapper* const self = SUIL_COCOA_WRAPPER(gobject);
 
+  suil_scheduler_remove(&self->frame);
   self->wrapper->impl = NULL;
 
   G_OBJECT_CLASS(suil_cocoa_wrapper_parent_class)->finalize(gobject);
@@ -248,7 +246,7 @@ suil_cocoa_wrapper_init(SuilCocoaWrapper* self)
   self->alo_width   = 0;
   self->alo_height  = 0;
   self->idle_iface  = NULL;
-  self->idle_ms     = 1000 / 30; // 30 Hz default
+  self->update_rate = SUIL_DEFAULT_UPDATE_RATE;
 }
 
 static int
@@ -265,12 +263,16 @@ wrapper_resize(LV2UI_Feature_Handle handle, int width, int height)
   return 0;
 }
 
-static gboolean
+static void
 suil_cocoa_wrapper_idle(void* data)
 {
   SuilCocoaWrapper* const wrap = SUIL_COCOA_WRAPPER(data);
-  wrap->idle_iface->idle(wrap->instance->handle);
-  return TRUE; // Continue calling
+  SUIL_TRACE_BEGIN(wrap->instance->trace, "idle");
+  suil_instance_flush(wrap->instance);
+  if (wrap->idle_iface) {
+    wrap->idle_iface->idle(wrap->instance->handle);
+  }
+  SUIL_TRACE_END(wrap->instance->trace, "idle");
 }
 
 static GdkFilterReturn
@@ -343,9 +345,16 @@ wrapper_wrap(SuilWrapper* wrapper, SuilInstance* instance)
         LV2_UI__idleInterface);
   }
 
-  if (idle_iface) {
-    wrap->idle_iface = idle_iface;
-    wrap->idle_id = g_timeout_add(wrap->idle_ms, suil_cocoa_wrapper_idle, wrap);
+  wrap->idle_iface = idle_iface;
+  if (idle_iface || suil_instance_needs_flush(instance)) {
+    suil_scheduler_add(instance->scheduler,
+                       &wrap->frame,
+                       instance->controller,
+                       suil_cocoa_wrapper_idle,
+                       wrap,
+                       wrap->update_rate,
+                       suil_glib_start_timer,
+                       suil_glib_stop_timer);
   }
 
   return 0;
@@ -356,10 +365,7 @@ wrapper_free(SuilWrapper* wrapper)
 {
   if (wrapper->impl) {
     SuilCocoaWrapper* const wrap = SUIL_COCOA_WRAPPER(wrapper->impl);
-    if (wrap->idle_id) {
-      g_source_remove(wrap->idle_id);
-      wrap->idle_id = 0;
-    }
+    suil_scheduler_remove(&wrap->frame);
 
     gdk_window_remove_filter(wrap->flt_win, event_filter, wrapper->impl);
     gtk_object_destroy(GTK_OBJECT(wrap));
@@ -368,21 +374,16 @@ wrapper_free(SuilWrapper* wrapper)
 
 SUIL_LIB_EXPORT
 SuilWrapper*
-suil_wrapper_new(SuilHost*      host,
-                 const char*    host_type_uri,
-                 const char*    ui_type_uri,
-                 LV2_Feature*** features,
-                 unsigned       n_features)
+suil_wrapper_new(SuilHost*     host,
+                 const char*   host_type_uri,
+                 const char*   ui_type_uri,
+                 SuilFeatures* features)
 {
   (void)host;
   (void)host_type_uri;
 
-  GtkWidget* parent = NULL;
-  for (unsigned i = 0; i < n_features; ++i) {
-    if (!strcmp((*features)[i]->URI, LV2_UI__parent)) {
-      parent = (GtkWidget*)(*features)[i]->data;
-    }
-  }
+  GtkWidget* const parent =
+    (GtkWidget*)suil_get_feature(features, LV2_UI__parent);
 
   if (!GTK_CONTAINER(parent)) {
     SUIL_ERRORF("No GtkContainer parent given for %s UI\n", ui_type_uri);
@@ -410,31 +411,12 @@ suil_wrapper_new(SuilHost*      host,
   gdk_window_add_filter(wrap->flt_win, event_filter, wrap);
 
   NSView* parent_view = gdk_quartz_window_get_nsview(window);
-  suil_add_feature(features, &n_features, LV2_UI__parent, parent_view);
-  suil_add_feature(features, &n_features, LV2_UI__resize, &wrapper->resize);
-  suil_add_feature(features, &n_features, LV2_UI__idleInterface, NULL);
-
-  // Scan for URID map and options
-  LV2_URID_Map*       map     = NULL;
-  LV2_Options_Option* options = NULL;
-  for (LV2_Feature** f = *features; *f && (!map || !options); ++f) {
-    if (!strcmp((*f)->URI, LV2_OPTIONS__options)) {
-      options = (LV2_Options_Option*)(*f)->data;
-    } else if (!strcmp((*f)->URI, LV2_URID__map)) {
-      map = (LV2_URID_Map*)(*f)->data;
-    }
-  }
+  suil_add_feature(features, LV2_UI__parent, parent_view);
+  suil_add_feature(features, LV2_UI__resize, &wrapper->resize);
+  suil_add_feature(features, LV2_UI__idleInterface, NULL);
 
-  if (map && options) {
-    // Set UI update rate if given
-    LV2_URID ui_updateRate = map->map(map->handle, LV2_UI__updateRate);
-    for (LV2_Options_Option* o = options; o->key; ++o) {
-      if (o->key == ui_updateRate) {
-        wrap->idle_ms = static_cast<guint>(1000.0f / *(const float*)o->value);
-        break;
-      }
-    }
-  }
+  // Set UI update rate if given
+  wrap->update_rate = suil_get_update_rate(features);
 
   return wrapper;
 }
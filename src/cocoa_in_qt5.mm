@@ -1,12 +1,17 @@
 // Copyright 2011-2022 David Robillard <d@drobilla.net>
 // SPDX-License-Identifier: ISC
 
+#include "qt_timer.h"
+#include "scheduler.h"
 #include "suil_config.h"
 #include "suil_internal.h"
 
 #include <QCloseEvent>
+#include <QEvent>
+#include <QHideEvent>
 #include <QMacCocoaViewContainer>
-#include <QTimerEvent>
+#include <QPointer>
+#include <QShowEvent>
 #include <QWidget>
 
 #undef signals
@@ -27,9 +32,14 @@ public:
     : QMacCocoaViewContainer(view, parent)
     , _instance(NULL)
     , _idle_iface(NULL)
-    , _ui_timer(0)
+    , _frame()
+    , _update_rate(SUIL_DEFAULT_UPDATE_RATE)
+    , _window_widget()
+    , _shown(false)
   {}
 
+  ~SuilQCocoaWidget() override { suil_scheduler_remove(&_frame); }
+
   void start_idle(SuilInstance*               instance,
                   const LV2UI_Idle_Interface* idle_iface)
   {
@@ -41,35 +51,93 @@ public:
     setMinimumWidth(static_cast<int>([view fittingSize].width));
     setMinimumHeight(static_cast<int>([view fittingSize].height));
 
-    if (_idle_iface && _ui_timer == 0) {
-      _ui_timer = this->startTimer(30);
+    if ((_idle_iface || suil_instance_needs_flush(instance)) &&
+        !_frame.scheduler) {
+      suil_scheduler_add(instance->scheduler,
+                         &_frame,
+                         instance->controller,
+                         on_frame,
+                         this,
+                         _update_rate,
+                         suil_qt_start_timer,
+                         suil_qt_stop_timer);
     }
   }
 
+  void set_update_rate(float update_rate) { _update_rate = update_rate; }
+
 protected:
-  void timerEvent(QTimerEvent* event) override
+  void showEvent(QShowEvent* event) override
   {
-    if (event->timerId() == _ui_timer && _idle_iface) {
-      _idle_iface->idle(_instance->handle);
+    QMacCocoaViewContainer::showEvent(event);
+    watch_window();
+    _shown = true;
+    update_visibility();
+  }
+
+  void hideEvent(QHideEvent* event) override
+  {
+    QMacCocoaViewContainer::hideEvent(event);
+    _shown = false; // Also sent when minimized or moved to another desktop
+    update_visibility();
+  }
+
+  bool eventFilter(QObject* object, QEvent* event) override
+  {
+    if (object == _window_widget &&
+        event->type() == QEvent::WindowStateChange) {
+      update_visibility();
     }
 
-    QWidget::timerEvent(event);
+    return QMacCocoaViewContainer::eventFilter(object, event);
   }
 
   void closeEvent(QCloseEvent* event) override
   {
-    if (_ui_timer && _idle_iface) {
-      this->killTimer(_ui_timer);
-      _ui_timer = 0;
-    }
+    suil_scheduler_remove(&_frame);
 
     QWidget::closeEvent(event);
   }
 
 private:
+  /// Watch the window's state, which is only sent to the top-level widget
+  void watch_window()
+  {
+    QWidget* const window_widget = window();
+    if (window_widget != _window_widget) {
+      if (_window_widget) {
+        _window_widget->removeEventFilter(this);
+      }
+
+      _window_widget = window_widget;
+      _window_widget->installEventFilter(this);
+    }
+  }
+
+  /// Slow down the UI while it can't be seen, and restore it once it can
+  void update_visibility()
+  {
+    suil_scheduler_set_visible(&_frame, _shown && !window()->isMinimized());
+  }
+
+  static void on_frame(void* data)
+  {
+    SuilQCocoaWidget* const self = (SuilQCocoaWidget*)data;
+
+    SUIL_TRACE_BEGIN(self->_instance->trace, "idle");
+    suil_instance_flush(self->_instance);
+    if (self->_idle_iface) {
+      self->_idle_iface->idle(self->_instance->handle);
+    }
+    SUIL_TRACE_END(self->_instance->trace, "idle");
+  }
+
   SuilInstance*               _instance;
   const LV2UI_Idle_Interface* _idle_iface;
-  int                         _ui_timer;
+  SuilFrameEntry              _frame;
+  float                       _update_rate;
+  QPointer<QWidget>           _window_widget;
+  bool                        _shown;
 };
 
 static void
@@ -90,13 +158,15 @@ wrapper_wrap(SuilWrapper* wrapper, SuilInstance* instance)
   SuilCocoaInQt5Wrapper* const impl = (SuilCocoaInQt5Wrapper*)wrapper->impl;
   SuilQCocoaWidget* const      ew   = (SuilQCocoaWidget*)impl->parent;
 
+  const LV2UI_Idle_Interface* idle_iface = NULL;
   if (instance->descriptor->extension_data) {
-    const LV2UI_Idle_Interface* idle_iface =
+    idle_iface =
       (const LV2UI_Idle_Interface*)instance->descriptor->extension_data(
         LV2_UI__idleInterface);
-    ew->start_idle(instance, idle_iface);
   }
 
+  ew->start_idle(instance, idle_iface);
+
   impl->host_widget = ew;
 
   instance->host_widget = impl->host_widget;
@@ -114,21 +184,15 @@ wrapper_resize(LV2UI_Feature_Handle handle, int width, int height)
 
 SUIL_LIB_EXPORT
 SuilWrapper*
-suil_wrapper_new(SuilHost*      host,
-                 const char*    host_type_uri,
-                 const char*    ui_type_uri,
-                 LV2_Feature*** features,
-                 unsigned       n_features)
+suil_wrapper_new(SuilHost*     host,
+                 const char*   host_type_uri,
+                 const char*   ui_type_uri,
+                 SuilFeatures* features)
 {
   (void)host;
   (void)host_type_uri;
 
-  QWidget* parent = NULL;
-  for (unsigned i = 0; i < n_features; ++i) {
-    if (!strcmp((*features)[i]->URI, LV2_UI__parent)) {
-      parent = (QWidget*)(*features)[i]->data;
-    }
-  }
+  QWidget* const parent = (QWidget*)suil_get_feature(features, LV2_UI__parent);
 
   if (!parent) {
     SUIL_ERRORF("No QWidget parent given for %s UI\n", ui_type_uri);
@@ -152,9 +216,12 @@ suil_wrapper_new(SuilHost*      host,
   wrapper->resize.handle    = ew;
   wrapper->resize.ui_resize = wrapper_resize;
 
-  suil_add_feature(features, &n_features, LV2_UI__parent, ew->cocoaView());
-  suil_add_feature(features, &n_features, LV2_UI__resize, &wrapper->resize);
-  suil_add_feature(features, &n_features, LV2_UI__idleInterface, NULL);
+  suil_add_feature(features, LV2_UI__parent, ew->cocoaView());
+  suil_add_feature(features, LV2_UI__resize, &wrapper->resize);
+  suil_add_feature(features, LV2_UI__idleInterface, NULL);
+
+  // Set UI update rate if given
+  ew->set_update_rate(suil_get_update_rate(features));
 
   return wrapper;
 }
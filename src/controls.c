@@ -0,0 +1,92 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#include "suil_internal.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Grow a set of controls so that it has a slot for `index`
+static int
+grow(SuilControls* const controls, const uint32_t index)
+{
+  uint32_t n_ports = controls->n_ports ? controls->n_ports : 32U;
+  while (n_ports <= index) {
+    if (n_ports > UINT32_MAX / 2U) {
+      return 1;
+    }
+
+    n_ports *= 2U;
+  }
+
+  const uint32_t old_n_words = controls->n_ports / 32U;
+  const uint32_t new_n_words = n_ports / 32U;
+
+  float* const values =
+    (float*)realloc(controls->values, n_ports * sizeof(float));
+  if (!values) {
+    return 1;
+  }
+
+  controls->values = values;
+
+  uint32_t* const dirty =
+    (uint32_t*)realloc(controls->dirty, new_n_words * sizeof(uint32_t));
+  if (!dirty) {
+    return 1;
+  }
+
+  memset(dirty + old_n_words,
+         0,
+         (new_n_words - old_n_words) * sizeof(uint32_t));
+
+  controls->dirty   = dirty;
+  controls->n_ports = n_ports;
+  return 0;
+}
+
+int
+suil_controls_set(SuilControls* const controls,
+                  const uint32_t      index,
+                  const float         value)
+{
+  if (index >= controls->n_ports && grow(controls, index)) {
+    return 1;
+  }
+
+  controls->values[index] = value;
+  controls->dirty[index / 32U] |= 1U << (index % 32U);
+  return 0;
+}
+
+void
+suil_controls_flush(SuilControls* const   controls,
+                    const SuilControlFunc func,
+                    void* const           data)
+{
+  const uint32_t n_words = controls->n_ports / 32U;
+  for (uint32_t w = 0U; w < n_words; ++w) {
+    uint32_t bits = controls->dirty[w];
+    if (!bits) {
+      continue;
+    }
+
+    // Clear first, since func may set values again
+    controls->dirty[w] = 0U;
+    for (uint32_t b = 0U; bits; ++b, bits >>= 1U) {
+      if (bits & 1U) {
+        const uint32_t index = (w * 32U) + b;
+        func(data, index, controls->values[index]);
+      }
+    }
+  }
+}
+
+void
+suil_controls_cleanup(SuilControls* const controls)
+{
+  free(controls->dirty);
+  free(controls->values);
+  memset(controls, 0, sizeof(SuilControls));
+}
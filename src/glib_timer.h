@@ -0,0 +1,41 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#ifndef SUIL_GLIB_TIMER_H
+#define SUIL_GLIB_TIMER_H
+
+#include "scheduler.h"
+#include "warnings.h"
+
+SUIL_DISABLE_GTK_WARNINGS
+#include <glib.h>
+SUIL_RESTORE_WARNINGS
+
+#include <stdint.h>
+
+/// Run a frame of the scheduler for a GLib timer
+static inline gboolean
+suil_glib_on_frame(gpointer data)
+{
+  suil_scheduler_run((SuilScheduler*)data);
+  return TRUE; // Continue calling
+}
+
+/// Start a GLib timer to drive a scheduler (a SuilTimerStartFunc)
+static inline void*
+suil_glib_start_timer(SuilScheduler* const scheduler)
+{
+  const guint id = g_timeout_add(
+    suil_scheduler_interval(scheduler), suil_glib_on_frame, scheduler);
+
+  return (void*)(uintptr_t)id;
+}
+
+/// Stop a timer started by suil_glib_start_timer() (a SuilTimerStopFunc)
+static inline void
+suil_glib_stop_timer(void* const timer)
+{
+  g_source_remove((guint)(uintptr_t)timer);
+}
+
+#endif // SUIL_GLIB_TIMER_H
@@ -2,13 +2,16 @@
 // Copyright 2017 Stefan Westerfeld <stefan@space.twc.de>
 // SPDX-License-Identifier: ISC
 
+#include "atomic.h"
 #include "dylib.h"
 #include "suil_config.h"
 #include "suil_internal.h"
+#include "thread.h"
 
 #include <suil/suil.h>
 
 #include <stdlib.h>
+#include <string.h>
 
 int    suil_argc = 0;
 char** suil_argv = NULL;
@@ -20,7 +23,29 @@ suil_host_new(SuilPortWriteFunc       write_func,
               SuilPortUnsubscribeFunc unsubscribe_func)
 {
   SuilHost* host = (SuilHost*)calloc(1, sizeof(struct SuilHostImpl));
+  if (!host || suil_mutex_init(&host->mutex)) {
+    free(host);
+    return NULL;
+  }
+
+  if (suil_cond_init(&host->cond)) {
+    suil_mutex_destroy(&host->mutex);
+    free(host);
+    return NULL;
+  }
+
+  if (!(host->scheduler = (SuilScheduler*)calloc(1, sizeof(SuilScheduler)))) {
+    suil_cond_destroy(&host->cond);
+    suil_mutex_destroy(&host->mutex);
+    free(host);
+    return NULL;
+  }
+
+  host->scheduler->now  = suil_clock_now;
+  host->scheduler->rate = SUIL_FRAME_RATE;
+  host->scheduler->refs = 1U;
 
+  host->trace            = suil_trace_open();
   host->write_func       = write_func;
   host->index_func       = index_func;
   host->subscribe_func   = subscribe_func;
@@ -37,18 +62,232 @@ suil_host_set_touch_func(SuilHost* host, SuilTouchFunc touch_func)
   host->touch_func = touch_func;
 }
 
+SUIL_API void
+suil_host_set_port_event_queue_size(SuilHost* host, uint32_t size)
+{
+  host->queue_size = size;
+}
+
+SUIL_API void
+suil_host_set_coalesce_controls(SuilHost* host, bool coalesce)
+{
+  host->coalesce_controls = coalesce;
+}
+
+SUIL_API void
+suil_host_set_coalesce_writes(SuilHost* host, bool coalesce)
+{
+  host->coalesce_writes = coalesce;
+}
+
+SUIL_API void
+suil_host_set_frame_rate(SuilHost* host, uint32_t rate)
+{
+  if (rate) {
+    host->scheduler->rate = rate;
+  }
+}
+
+SUIL_API void
+suil_host_set_frame_clock_idle(SuilHost* host, bool frame_clock)
+{
+  host->frame_clock_idle = frame_clock;
+}
+
+SUIL_API void
+suil_host_set_idle_budget(SuilHost*            host,
+                          uint64_t             budget,
+                          SuilIdleWatchdogFunc watchdog_func,
+                          void*                watchdog_data)
+{
+  host->scheduler->budget        = budget;
+  host->scheduler->watchdog      = watchdog_func;
+  host->scheduler->watchdog_data = watchdog_data;
+}
+
+SUIL_API void
+suil_host_set_stats_func(SuilHost*             host,
+                         SuilInstanceStatsFunc stats_func,
+                         void*                 stats_data)
+{
+  host->stats_func = stats_func;
+  host->stats_data = stats_data;
+}
+
+SUIL_API SuilCacheStats
+suil_host_get_cache_stats(SuilHost* host)
+{
+  suil_mutex_lock(&host->mutex);
+  const SuilCacheStats stats = host->cache_stats;
+  suil_mutex_unlock(&host->mutex);
+
+  return stats;
+}
+
+/// Load every module for wrapping UIs in the preload type, in a thread
+static void
+preload_modules(void* const data)
+{
+  SuilHost* const host = (SuilHost*)data;
+
+  for (unsigned i = 1U; i <= (unsigned)SUIL_UI_TYPE_COCOA; ++i) {
+    const char* const name =
+      suil_wrapper_module(host->preload_type, (SuilUIType)i);
+
+    if (name) {
+      // Drop our reference, the module stays loaded in the host cache
+      suil_module_unref(suil_host_get_module(host, name));
+    }
+  }
+}
+
+SUIL_API int
+suil_host_preload(SuilHost* host, const char* container_type_uri)
+{
+  const SuilUIType container_type = suil_ui_type(container_type_uri);
+  if (!container_type) {
+    return 1;
+  }
+
+  // Wait for any previous preload to finish
+  if (host->preloading) {
+    suil_thread_join(&host->preload_thread);
+    host->preloading = false;
+  }
+
+  host->preload_type = container_type;
+  if (suil_thread_start(&host->preload_thread, preload_modules, host)) {
+    return 1;
+  }
+
+  host->preloading = true;
+  return 0;
+}
+
 SUIL_API void
 suil_host_free(SuilHost* host)
 {
   if (host) {
+    if (host->preloading) {
+      suil_thread_join(&host->preload_thread);
+    }
+
+    // Stop the loader thread, which is idle since every request is finished
+    if (host->loading) {
+      suil_mutex_lock(&host->mutex);
+      host->stopping = true;
+      suil_cond_broadcast(&host->cond);
+      suil_mutex_unlock(&host->mutex);
+      suil_thread_join(&host->loader);
+    }
+
+    // Detach libraries (which are owned by the instances that use them)
+    suil_mutex_lock(&host->mutex);
+    for (SuilLibrary* l = host->libraries; l; l = l->next) {
+      l->host = NULL;
+    }
+    suil_mutex_unlock(&host->mutex);
+
+    // Drop cache references (modules still used by instances stay loaded)
+    for (SuilModule* m = host->modules; m;) {
+      SuilModule* const next = m->next;
+      suil_module_unref(m);
+      m = next;
+    }
+
     if (host->gtk_lib) {
       dylib_close(host->gtk_lib);
     }
 
+    // Drop scheduler reference (it stays alive while wrappers use it)
+    suil_scheduler_unref(host->scheduler);
+
+    suil_cond_destroy(&host->cond);
+    suil_mutex_destroy(&host->mutex);
     free(host);
   }
 }
 
+/// Return a new reference to a cached module, or null, with the host locked
+static SuilModule*
+find_module(SuilHost* const host, const char* const name)
+{
+  for (SuilModule* m = host->modules; m; m = m->next) {
+    if (!strcmp(m->name, name)) {
+      suil_atomic_add(&m->refs, 1U);
+      ++host->cache_stats.module_hits;
+      return m;
+    }
+  }
+
+  return NULL;
+}
+
+SuilModule*
+suil_host_get_module(SuilHost* const host, const char* const name)
+{
+  // Return the cached module if it has already been loaded
+  suil_mutex_lock(&host->mutex);
+  SuilModule* const cached = find_module(host, name);
+  suil_mutex_unlock(&host->mutex);
+  if (cached) {
+    return cached;
+  }
+
+  // Load the module without holding the lock, since this can be slow
+  void* const lib = suil_open_module(name);
+  if (!lib) {
+    return NULL;
+  }
+
+  const SuilWrapperNewFunc wrapper_new =
+    (SuilWrapperNewFunc)suil_dlfunc(lib, "suil_wrapper_new");
+  if (!wrapper_new) {
+    SUIL_ERRORF("Corrupt wrap module %s\n", name);
+    dylib_close(lib);
+    return NULL;
+  }
+
+  SuilModule* const module = (SuilModule*)calloc(1, sizeof(SuilModule));
+  if (!module) {
+    dylib_close(lib);
+    return NULL;
+  }
+
+  // Use the cached module instead if another thread loaded it meanwhile
+  suil_mutex_lock(&host->mutex);
+  SuilModule* const loaded = find_module(host, name);
+  if (loaded) {
+    suil_mutex_unlock(&host->mutex);
+    dylib_close(lib); // Only drops the extra reference held by the loader
+    free(module);
+    return loaded;
+  }
+
+  module->next        = host->modules;
+  module->name        = name;
+  module->lib         = lib;
+  module->wrapper_new = wrapper_new;
+  module->refs        = 2U; // One for the host cache, one for the caller
+  host->modules       = module;
+
+  ++host->cache_stats.module_misses;
+  suil_mutex_unlock(&host->mutex);
+  return module;
+}
+
+void
+suil_module_unref(SuilModule* const module)
+{
+  if (module && !suil_atomic_sub(&module->refs, 1U)) {
+#ifndef _WIN32
+    // Never unload modules on windows, causes mysterious segfaults
+    dylib_close(module->lib);
+#endif
+    free(module);
+  }
+}
+
 #if USE_X11
 static void
 suil_load_init_module(const char* module_name)
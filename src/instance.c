@@ -1,99 +1,135 @@
 // Copyright 2007-2022 David Robillard <d@drobilla.net>
 // SPDX-License-Identifier: ISC
 
-#include "dylib.h"
 #include "suil_internal.h"
+#include "thread.h"
 
 #include <lv2/core/lv2.h>
 #include <lv2/ui/ui.h>
 #include <suil/suil.h>
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define GTK2_UI_URI LV2_UI__GtkUI
-#define GTK3_UI_URI LV2_UI__Gtk3UI
-#define QT5_UI_URI LV2_UI__Qt5UI
-#define QT6_UI_URI LV2_UI_PREFIX "Qt6UI"
-#define X11_UI_URI LV2_UI__X11UI
-#define WIN_UI_URI LV2_UI_PREFIX "WindowsUI"
-#define COCOA_UI_URI LV2_UI__CocoaUI
-
-SUIL_API unsigned
-suil_ui_supported(const char* host_type_uri, const char* ui_type_uri)
+enum {
+  SUIL_WRAPPING_UNSUPPORTED = 0,
+  SUIL_WRAPPING_NATIVE      = 1,
+  SUIL_WRAPPING_EMBEDDED    = 2
+};
+
+#define SUIL_N_UI_TYPES ((unsigned)SUIL_UI_TYPE_COCOA + 1U)
+
+/// A way of wrapping one UI type in another
+typedef struct {
+  unsigned    support; ///< Quality of wrapping, as in suil_ui_supported()
+  const char* module;  ///< Name of the wrapper module, or null
+} SuilWrapping;
+
+/// Names of UI types, which all start with LV2_UI_PREFIX
+static const char* const ui_type_names[SUIL_N_UI_TYPES] = {
+  NULL,
+  "GtkUI",
+  "Gtk3UI",
+  "Qt5UI",
+  "Qt6UI",
+  "X11UI",
+  "WindowsUI",
+  "CocoaUI",
+};
+
+/// Supported wrappings indexed by container type, then UI type
+static const SuilWrapping wrappings[SUIL_N_UI_TYPES][SUIL_N_UI_TYPES] = {
+  [SUIL_UI_TYPE_GTK2] =
+    {
+      [SUIL_UI_TYPE_X11]     = {SUIL_WRAPPING_EMBEDDED, "suil_x11_in_gtk2"},
+      [SUIL_UI_TYPE_WINDOWS] = {SUIL_WRAPPING_EMBEDDED, "suil_win_in_gtk2"},
+      [SUIL_UI_TYPE_COCOA]   = {SUIL_WRAPPING_EMBEDDED, "suil_cocoa_in_gtk2"},
+    },
+  [SUIL_UI_TYPE_GTK3] =
+    {
+      [SUIL_UI_TYPE_X11] = {SUIL_WRAPPING_EMBEDDED, "suil_x11_in_gtk3"},
+    },
+  [SUIL_UI_TYPE_QT5] =
+    {
+      [SUIL_UI_TYPE_X11]   = {SUIL_WRAPPING_EMBEDDED, "suil_x11_in_qt5"},
+      [SUIL_UI_TYPE_COCOA] = {SUIL_WRAPPING_EMBEDDED, "suil_cocoa_in_qt5"},
+    },
+  [SUIL_UI_TYPE_QT6] =
+    {
+      [SUIL_UI_TYPE_X11] = {SUIL_WRAPPING_EMBEDDED, "suil_x11_in_qt6"},
+    },
+};
+
+SUIL_API SuilUIType
+suil_ui_type(const char* const uri)
 {
-  enum {
-    SUIL_WRAPPING_UNSUPPORTED = 0,
-    SUIL_WRAPPING_NATIVE      = 1,
-    SUIL_WRAPPING_EMBEDDED    = 2
-  };
-
-  if (!strcmp(host_type_uri, ui_type_uri)) {
-    return SUIL_WRAPPING_NATIVE;
-  }
-
-  if ((!strcmp(host_type_uri, GTK2_UI_URI) &&
-       (!strcmp(ui_type_uri, COCOA_UI_URI) ||
-        !strcmp(ui_type_uri, WIN_UI_URI) ||
-        !strcmp(ui_type_uri, X11_UI_URI))) ||
-      (!strcmp(host_type_uri, GTK3_UI_URI) &&
-       !strcmp(ui_type_uri, X11_UI_URI)) ||
-      (!strcmp(host_type_uri, QT5_UI_URI) &&
-       (!strcmp(ui_type_uri, COCOA_UI_URI) ||
-        !strcmp(ui_type_uri, X11_UI_URI))) ||
-      (!strcmp(host_type_uri, QT6_UI_URI) &&
-       (!strcmp(ui_type_uri, X11_UI_URI)))) {
-    return SUIL_WRAPPING_EMBEDDED;
-  }
-
-  return SUIL_WRAPPING_UNSUPPORTED;
+  static const size_t prefix_len = sizeof(LV2_UI_PREFIX) - 1U;
+
+  if (!strncmp(uri, LV2_UI_PREFIX, prefix_len)) {
+    const char* const name = uri + prefix_len;
+    for (unsigned i = 1U; i < SUIL_N_UI_TYPES; ++i) {
+      if (!strcmp(name, ui_type_names[i])) {
+        return (SuilUIType)i;
+      }
+    }
+  }
+
+  return SUIL_UI_TYPE_UNKNOWN;
 }
 
-static SuilWrapper*
-open_wrapper(SuilHost*      host,
-             const char*    container_type_uri,
-             const char*    ui_type_uri,
-             LV2_Feature*** features,
-             unsigned       n_features)
+SUIL_API unsigned
+suil_ui_type_supported(const SuilUIType host_type, const SuilUIType ui_type)
 {
-  const char* module_name = NULL;
-
-  if (!strcmp(container_type_uri, GTK2_UI_URI) &&
-      !strcmp(ui_type_uri, X11_UI_URI)) {
-    module_name = "suil_x11_in_gtk2";
+  if (host_type == SUIL_UI_TYPE_UNKNOWN || ui_type == SUIL_UI_TYPE_UNKNOWN ||
+      (unsigned)host_type >= SUIL_N_UI_TYPES ||
+      (unsigned)ui_type >= SUIL_N_UI_TYPES) {
+    return SUIL_WRAPPING_UNSUPPORTED;
   }
 
-  if (!strcmp(container_type_uri, GTK3_UI_URI) &&
-      !strcmp(ui_type_uri, X11_UI_URI)) {
-    module_name = "suil_x11_in_gtk3";
-  }
+  return (host_type == ui_type) ? SUIL_WRAPPING_NATIVE
+                                : wrappings[host_type][ui_type].support;
+}
 
-  if (!strcmp(container_type_uri, GTK2_UI_URI) &&
-      !strcmp(ui_type_uri, WIN_UI_URI)) {
-    module_name = "suil_win_in_gtk2";
-  }
+SUIL_API unsigned
+suil_ui_supported(const char* host_type_uri, const char* ui_type_uri)
+{
+  const SuilUIType host_type = suil_ui_type(host_type_uri);
+  const SuilUIType ui_type   = suil_ui_type(ui_type_uri);
 
-  if (!strcmp(container_type_uri, GTK2_UI_URI) &&
-      !strcmp(ui_type_uri, COCOA_UI_URI)) {
-    module_name = "suil_cocoa_in_gtk2";
+  if (host_type && ui_type) {
+    return suil_ui_type_supported(host_type, ui_type);
   }
 
-  if (!strcmp(container_type_uri, QT5_UI_URI) &&
-      !strcmp(ui_type_uri, X11_UI_URI)) {
-    module_name = "suil_x11_in_qt5";
-  }
+  // Unknown types can only be supported natively
+  return strcmp(host_type_uri, ui_type_uri) ? SUIL_WRAPPING_UNSUPPORTED
+                                            : SUIL_WRAPPING_NATIVE;
+}
 
-  if (!strcmp(container_type_uri, QT6_UI_URI) &&
-      !strcmp(ui_type_uri, X11_UI_URI)) {
-    module_name = "suil_x11_in_qt6";
-  }
+const char*
+suil_wrapper_module(const SuilUIType container_type, const SuilUIType ui_type)
+{
+  return wrappings[container_type][ui_type].module;
+}
 
-  if (!strcmp(container_type_uri, QT5_UI_URI) &&
-      !strcmp(ui_type_uri, COCOA_UI_URI)) {
-    module_name = "suil_cocoa_in_qt5";
-  }
+/// Return the name of the module that wraps one UI type in another, or null
+static const char*
+wrapper_module_name(const char* container_type_uri, const char* ui_type_uri)
+{
+  return suil_wrapper_module(suil_ui_type(container_type_uri),
+                             suil_ui_type(ui_type_uri));
+}
+
+static SuilWrapper*
+open_wrapper(SuilHost*     host,
+             const char*   container_type_uri,
+             const char*   ui_type_uri,
+             SuilFeatures* features)
+{
+  const char* const module_name =
+    wrapper_module_name(container_type_uri, ui_type_uri);
 
   if (!module_name) {
     SUIL_ERRORF("Unable to wrap UI type <%s> as type <%s>\n",
@@ -102,101 +138,194 @@ open_wrapper(SuilHost*      host,
     return NULL;
   }
 
-  void* const lib = suil_open_module(module_name);
-  if (!lib) {
+  SuilModule* const module = suil_host_get_module(host, module_name);
+  if (!module) {
     return NULL;
   }
 
-  SuilWrapperNewFunc wrapper_new =
-    (SuilWrapperNewFunc)suil_dlfunc(lib, "suil_wrapper_new");
-
-  SuilWrapper* wrapper =
-    wrapper_new
-      ? wrapper_new(host, container_type_uri, ui_type_uri, features, n_features)
-      : NULL;
+  SuilWrapper* const wrapper =
+    module->wrapper_new(host, container_type_uri, ui_type_uri, features);
 
   if (wrapper) {
-    wrapper->lib = lib;
+    wrapper->module = module;
   } else {
-    SUIL_ERRORF("Corrupt wrap module %s\n", module_name);
-    dylib_close(lib);
+    suil_module_unref(module);
   }
 
   return wrapper;
 }
 
-SUIL_API SuilInstance*
-suil_instance_new(SuilHost*                 host,
-                  SuilController            controller,
-                  const char*               container_type_uri,
-                  const char*               plugin_uri,
-                  const char*               ui_uri,
-                  const char*               ui_type_uri,
-                  const char*               ui_bundle_path,
-                  const char*               ui_binary_path,
-                  const LV2_Feature* const* features)
+/// Forward the latest value of a coalesced control write to the host
+static void
+forward_write(void* const data, const uint32_t index, const float value)
 {
-  // Open UI library
-  dylib_error();
-  void* lib = dylib_open(ui_binary_path, DYLIB_NOW);
-  if (!lib) {
-    SUIL_ERRORF(
-      "Unable to open UI library %s (%s)\n", ui_binary_path, dylib_error());
-    return NULL;
+  SuilInstance* const instance = (SuilInstance*)data;
+
+  instance->write_func(
+    instance->controller, index, sizeof(float), 0U, &value);
+}
+
+/// Write function given to the UI if writes are coalesced
+static void
+coalesce_write(void* const       controller,
+               const uint32_t    port_index,
+               const uint32_t    buffer_size,
+               const uint32_t    protocol,
+               const void* const buffer)
+{
+  SuilInstance* const instance = (SuilInstance*)controller;
+
+  if (!protocol && buffer_size == sizeof(float)) {
+    float value = 0.0f;
+    memcpy(&value, buffer, sizeof(value));
+    if (!suil_controls_set(&instance->writes, port_index, value)) {
+      return; // Forwarded by the next flush
+    }
+  } else {
+    // Forward pending control writes first to preserve their order
+    suil_controls_flush(&instance->writes, forward_write, instance);
   }
 
-  // Get discovery function
-  LV2UI_DescriptorFunction df =
-    (LV2UI_DescriptorFunction)suil_dlfunc(lib, "lv2ui_descriptor");
-  if (!df) {
-    SUIL_ERRORF("Broken LV2 UI %s (no lv2ui_descriptor symbol found)\n",
-                ui_binary_path);
-    dylib_close(lib);
+  instance->write_func(
+    instance->controller, port_index, buffer_size, protocol, buffer);
+}
+
+/// Touch function given to the UI if writes are coalesced
+static void
+coalesce_touch(void* const    controller,
+               const uint32_t port_index,
+               const bool     grabbed)
+{
+  SuilInstance* const instance = (SuilInstance*)controller;
+
+  // Forward pending control writes first, so gestures end after their values
+  suil_controls_flush(&instance->writes, forward_write, instance);
+
+  instance->touch_func(instance->controller, port_index, grabbed);
+}
+
+/// Return the time since `*start` and set `*start` to now
+static uint64_t
+lap(uint64_t* const start)
+{
+  const uint64_t now     = suil_clock_now();
+  const uint64_t elapsed = now - *start;
+
+  *start = now;
+  return elapsed;
+}
+
+/**
+   Load the library of a UI and find its descriptor.
+
+   This only uses the host caches, so it may be called from any thread.
+
+   @return The UI descriptor, or null on error, in which case `library` is set
+   to null.
+*/
+static const LV2UI_Descriptor*
+load_descriptor(SuilHost* const          host,
+                const char* const        ui_uri,
+                const char* const        ui_binary_path,
+                SuilLibrary** const      library,
+                SuilInstanceStats* const stats)
+{
+  uint64_t t = suil_clock_now();
+
+  SUIL_TRACE_BEGIN(host->trace, "load_descriptor");
+
+  // Get UI library (which may already be loaded)
+  *library         = suil_host_get_library(host, ui_binary_path);
+  stats->load_time = lap(&t);
+  if (!*library) {
+    SUIL_TRACE_END(host->trace, "load_descriptor");
     return NULL;
   }
 
   // Get UI descriptor
-  const LV2UI_Descriptor* descriptor = NULL;
-  for (uint32_t i = 0; true; ++i) {
-    const LV2UI_Descriptor* ld = df(i);
-    if (!ld) {
-      break;
-    }
+  const LV2UI_Descriptor* const descriptor =
+    suil_library_get_descriptor(*library, ui_uri);
 
-    if (!strcmp(ld->URI, ui_uri)) {
-      descriptor = ld;
-      break;
-    }
-  }
+  stats->lookup_time = lap(&t);
 
   if (!descriptor) {
     SUIL_ERRORF(
       "Failed to find descriptor for <%s> in %s\n", ui_uri, ui_binary_path);
-    dylib_close(lib);
-    return NULL;
+    suil_library_unref(*library);
+    *library = NULL;
   }
 
-  // Create SuilInstance
-  SuilInstance* instance = (SuilInstance*)calloc(1, sizeof(SuilInstance));
+  SUIL_TRACE_END(host->trace, "load_descriptor");
+  return descriptor;
+}
+
+/**
+   Instantiate and wrap a UI from a loaded library.
+
+   This takes ownership of the reference to `library`, and must be called from
+   the UI thread.  The `stats` must contain the times from load_descriptor().
+*/
+static SuilInstance*
+create_instance(const SuilInstanceStats* const  stats,
+                SuilHost* const                 host,
+                const SuilController            controller,
+                const char* const               container_type_uri,
+                const char* const               plugin_uri,
+                const char* const               ui_uri,
+                const char* const               ui_type_uri,
+                const char* const               ui_bundle_path,
+                const char* const               ui_binary_path,
+                const LV2_Feature* const* const features,
+                SuilLibrary* const              library,
+                const LV2UI_Descriptor* const   descriptor)
+{
+  uint64_t t = suil_clock_now();
+
+  // Count user provided features to size the feature array
+  uint32_t n_host_features = 0U;
+  while (features && features[n_host_features]) {
+    ++n_host_features;
+  }
+
+  const uint32_t capacity =
+    n_host_features + SUIL_N_INSTANCE_FEATURES + SUIL_N_WRAPPER_FEATURES;
+  const uint32_t n_slots = suil_features_n_slots(capacity);
+
+  // Create SuilInstance with space for features in the same allocation
+  SuilInstance* instance = (SuilInstance*)calloc(
+    1, sizeof(SuilInstance) + suil_features_size(capacity, n_slots));
   if (!instance) {
     SUIL_ERRORF("Failed to allocate memory for <%s> instance\n", ui_uri);
-    dylib_close(lib);
+    suil_library_unref(library);
     return NULL;
   }
 
-  instance->lib_handle = lib;
-  instance->descriptor = descriptor;
+  instance->library           = library;
+  instance->descriptor        = descriptor;
+  instance->coalesce_controls = host->coalesce_controls;
+  instance->coalesce_writes   = host->coalesce_writes && host->write_func;
+  instance->write_func        = host->write_func;
+  instance->touch_func        = host->touch_func;
+  instance->controller        = controller;
+  instance->stats             = *stats;
+  instance->stats_func        = host->stats_func;
+  instance->stats_data        = host->stats_data;
+  instance->trace             = host->trace;
+  instance->scheduler         = host->scheduler;
+
+  // Allocate port event queue if enabled
+  if (suil_queue_init(&instance->queue, host->queue_size)) {
+    SUIL_ERRORF("Failed to allocate port event queue for <%s>\n", ui_uri);
+    suil_instance_free(instance);
+    return NULL;
+  }
 
   // Make UI features array
-  instance->features    = (LV2_Feature**)malloc(sizeof(LV2_Feature*));
-  instance->features[0] = NULL;
+  suil_features_init(&instance->features, instance + 1, capacity, n_slots);
 
   // Copy user provided features
-  const LV2_Feature* const* fi         = features;
-  unsigned                  n_features = 0;
-  while (fi && *fi) {
-    const LV2_Feature* f = *fi++;
-    suil_add_feature(&instance->features, &n_features, f->URI, f->data);
+  for (uint32_t i = 0U; i < n_host_features; ++i) {
+    suil_add_feature(&instance->features, features[i]->URI, features[i]->data);
   }
 
   // Add additional features implemented by SuilHost functions
@@ -204,45 +333,53 @@ suil_instance_new(SuilHost*                 host,
     instance->port_map.handle     = controller;
     instance->port_map.port_index = host->index_func;
     suil_add_feature(
-      &instance->features, &n_features, LV2_UI__portMap, &instance->port_map);
+      &instance->features, LV2_UI__portMap, &instance->port_map);
   }
 
   if (host->subscribe_func && host->unsubscribe_func) {
     instance->port_subscribe.handle      = controller;
     instance->port_subscribe.subscribe   = host->subscribe_func;
     instance->port_subscribe.unsubscribe = host->unsubscribe_func;
-    suil_add_feature(&instance->features,
-                     &n_features,
-                     LV2_UI__portSubscribe,
-                     &instance->port_subscribe);
+    suil_add_feature(
+      &instance->features, LV2_UI__portSubscribe, &instance->port_subscribe);
   }
 
   if (host->touch_func) {
-    instance->touch.handle = controller;
-    instance->touch.touch  = host->touch_func;
-    suil_add_feature(
-      &instance->features, &n_features, LV2_UI__touch, &instance->touch);
+    const bool coalesce = instance->coalesce_writes;
+
+    instance->touch.handle = coalesce ? (SuilController)instance : controller;
+    instance->touch.touch  = coalesce ? coalesce_touch : host->touch_func;
+    suil_add_feature(&instance->features, LV2_UI__touch, &instance->touch);
   }
 
+  instance->stats.features_time = lap(&t);
+
   // Open wrapper (this may add additional features)
   if (container_type_uri && strcmp(container_type_uri, ui_type_uri)) {
     instance->wrapper = open_wrapper(
-      host, container_type_uri, ui_type_uri, &instance->features, n_features);
+      host, container_type_uri, ui_type_uri, &instance->features);
+
+    // Add to any time spent loading the module in the background
+    instance->stats.open_wrapper_time += lap(&t);
     if (!instance->wrapper) {
       suil_instance_free(instance);
       return NULL;
     }
   }
 
-  // Instantiate UI
-  instance->handle =
-    descriptor->instantiate(descriptor,
-                            plugin_uri,
-                            ui_bundle_path,
-                            host->write_func,
-                            controller,
-                            &instance->ui_widget,
-                            (const LV2_Feature* const*)instance->features);
+  // Instantiate UI, with ourselves as the controller if writes are coalesced
+  SUIL_TRACE_BEGIN(instance->trace, "instantiate");
+  instance->handle = descriptor->instantiate(
+    descriptor,
+    plugin_uri,
+    ui_bundle_path,
+    instance->coalesce_writes ? coalesce_write : host->write_func,
+    instance->coalesce_writes ? (SuilController)instance : controller,
+    &instance->ui_widget,
+    (const LV2_Feature* const*)instance->features.array);
+
+  SUIL_TRACE_END(instance->trace, "instantiate");
+  instance->stats.instantiate_time = lap(&t);
 
   // Failed to instantiate UI
   if (!instance->handle) {
@@ -253,7 +390,12 @@ suil_instance_new(SuilHost*                 host,
   }
 
   if (instance->wrapper) {
-    if (instance->wrapper->wrap(instance->wrapper, instance)) {
+    SUIL_TRACE_BEGIN(instance->trace, "wrap");
+    const int st = instance->wrapper->wrap(instance->wrapper, instance);
+    SUIL_TRACE_END(instance->trace, "wrap");
+
+    instance->stats.wrap_time = lap(&t);
+    if (st) {
       SUIL_ERRORF(
         "Failed to wrap UI <%s> in type <%s>\n", ui_uri, container_type_uri);
       suil_instance_free(instance);
@@ -266,40 +408,316 @@ suil_instance_new(SuilHost*                 host,
   return instance;
 }
 
+SUIL_API SuilInstance*
+suil_instance_new(SuilHost*                 host,
+                  SuilController            controller,
+                  const char*               container_type_uri,
+                  const char*               plugin_uri,
+                  const char*               ui_uri,
+                  const char*               ui_type_uri,
+                  const char*               ui_bundle_path,
+                  const char*               ui_binary_path,
+                  const LV2_Feature* const* features)
+{
+  SuilInstanceStats stats   = {0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U};
+  SuilLibrary*      library = NULL;
+
+  const LV2UI_Descriptor* const descriptor =
+    load_descriptor(host, ui_uri, ui_binary_path, &library, &stats);
+
+  if (!descriptor) {
+    return NULL;
+  }
+
+  SUIL_TRACE_BEGIN(host->trace, "create_instance");
+
+  SuilInstance* const instance = create_instance(&stats,
+                                                 host,
+                                                 controller,
+                                                 container_type_uri,
+                                                 plugin_uri,
+                                                 ui_uri,
+                                                 ui_type_uri,
+                                                 ui_bundle_path,
+                                                 ui_binary_path,
+                                                 features,
+                                                 library,
+                                                 descriptor);
+
+  SUIL_TRACE_END(host->trace, "create_instance");
+  return instance;
+}
+
+/// A request to create an instance in the background
+struct SuilInstanceRequestImpl {
+  SuilHost*               host;
+  SuilController          controller;
+  const char*             container_type_uri;
+  const char*             plugin_uri;
+  const char*             ui_uri;
+  const char*             ui_type_uri;
+  const char*             ui_bundle_path;
+  const char*             ui_binary_path;
+  const LV2_Feature**     features;
+  SuilInstanceReadyFunc   ready_func;
+  void*                   ready_data;
+  SuilInstanceRequest*    next;       ///< Next request in the host queue
+  bool                    done;       ///< True once the loader is finished
+  SuilInstanceStats       stats;      ///< Times of loading phases
+  SuilLibrary*            library;    ///< Loaded UI library, or null
+  const LV2UI_Descriptor* descriptor; ///< UI descriptor, or null
+  SuilModule*             module;     ///< Loaded wrapper module, or null
+};
+
+/// Copy a string to `*dest` and return the end of the copy
+static char*
+copy_string(char* const dest, const char** const field, const char* const str)
+{
+  if (!str) {
+    *field = NULL;
+    return dest;
+  }
+
+  const size_t len = strlen(str) + 1U;
+  memcpy(dest, str, len);
+  *field = dest;
+  return dest + len;
+}
+
+/// Load everything needed for a request, in the loader thread
+static void
+load_request(SuilInstanceRequest* const request)
+{
+  request->descriptor = load_descriptor(request->host,
+                                        request->ui_uri,
+                                        request->ui_binary_path,
+                                        &request->library,
+                                        &request->stats);
+
+  // Load the wrapper module so that creating the wrapper only hits the cache
+  const char* const container_type_uri = request->container_type_uri;
+  if (request->descriptor && container_type_uri &&
+      strcmp(container_type_uri, request->ui_type_uri)) {
+    const char* const module_name =
+      wrapper_module_name(container_type_uri, request->ui_type_uri);
+
+    if (module_name) {
+      uint64_t t = suil_clock_now();
+
+      request->module = suil_host_get_module(request->host, module_name);
+
+      request->stats.open_wrapper_time = lap(&t);
+    }
+  }
+
+  request->ready_func(request->ready_data, request);
+}
+
+/// Load requests in the order they were made, until the host is freed
+static void
+run_loader(void* const data)
+{
+  SuilHost* const host = (SuilHost*)data;
+
+  suil_mutex_lock(&host->mutex);
+  for (;;) {
+    while (!host->requests && !host->stopping) {
+      suil_cond_wait(&host->cond, &host->mutex);
+    }
+
+    SuilInstanceRequest* const request = host->requests;
+    if (!request) {
+      break;
+    }
+
+    host->requests = request->next;
+    if (!host->requests) {
+      host->last_request = NULL;
+    }
+
+    // Load without holding the lock, which the host caches need
+    suil_mutex_unlock(&host->mutex);
+    load_request(request);
+    suil_mutex_lock(&host->mutex);
+
+    request->done = true;
+    suil_cond_broadcast(&host->cond);
+  }
+  suil_mutex_unlock(&host->mutex);
+}
+
+SUIL_API SuilInstanceRequest*
+suil_instance_new_async(SuilHost*                   host,
+                        SuilController              controller,
+                        const char*                 container_type_uri,
+                        const char*                 plugin_uri,
+                        const char*                 ui_uri,
+                        const char*                 ui_type_uri,
+                        const char*                 ui_bundle_path,
+                        const char*                 ui_binary_path,
+                        const LV2_Feature* const*   features,
+                        const SuilInstanceReadyFunc ready_func,
+                        void* const                 ready_data)
+{
+  const char* const strings[] = {container_type_uri,
+                                 plugin_uri,
+                                 ui_uri,
+                                 ui_type_uri,
+                                 ui_bundle_path,
+                                 ui_binary_path};
+
+  // Calculate the size of the request with copies of everything it refers to
+  size_t n_features = 0U;
+  while (features && features[n_features]) {
+    ++n_features;
+  }
+
+  const size_t features_size = (n_features + 1U) * sizeof(LV2_Feature*);
+  size_t       strings_size  = 0U;
+  for (size_t i = 0U; i < sizeof(strings) / sizeof(strings[0]); ++i) {
+    strings_size += strings[i] ? strlen(strings[i]) + 1U : 0U;
+  }
+
+  SuilInstanceRequest* const request = (SuilInstanceRequest*)calloc(
+    1, sizeof(SuilInstanceRequest) + features_size + strings_size);
+  if (!request) {
+    return NULL;
+  }
+
+  // Copy the feature array (but not the features themselves)
+  request->features = (const LV2_Feature**)(request + 1);
+  for (size_t i = 0U; i < n_features; ++i) {
+    request->features[i] = features[i];
+  }
+
+  // Copy strings
+  char* s = (char*)request->features + features_size;
+  s       = copy_string(s, &request->container_type_uri, container_type_uri);
+  s       = copy_string(s, &request->plugin_uri, plugin_uri);
+  s       = copy_string(s, &request->ui_uri, ui_uri);
+  s       = copy_string(s, &request->ui_type_uri, ui_type_uri);
+  s       = copy_string(s, &request->ui_bundle_path, ui_bundle_path);
+  copy_string(s, &request->ui_binary_path, ui_binary_path);
+
+  request->host       = host;
+  request->controller = controller;
+  request->ready_func = ready_func;
+  request->ready_data = ready_data;
+
+  // Start the loader thread of the host if it isn't already running
+  suil_mutex_lock(&host->mutex);
+  if (!host->loading) {
+    if (suil_thread_start(&host->loader, run_loader, host)) {
+      suil_mutex_unlock(&host->mutex);
+      SUIL_ERRORF("Failed to start thread to load <%s>\n", ui_uri);
+      free(request);
+      return NULL;
+    }
+
+    host->loading = true;
+  }
+
+  // Add the request to the end of the queue and wake the loader
+  if (host->last_request) {
+    host->last_request->next = request;
+  } else {
+    host->requests = request;
+  }
+
+  host->last_request = request;
+  suil_cond_broadcast(&host->cond);
+  suil_mutex_unlock(&host->mutex);
+
+  return request;
+}
+
+SUIL_API SuilInstance*
+suil_instance_new_finish(SuilInstanceRequest* request)
+{
+  SuilHost* const host = request->host;
+
+  // Wait until the loader is finished with the request
+  suil_mutex_lock(&host->mutex);
+  while (!request->done) {
+    suil_cond_wait(&host->cond, &host->mutex);
+  }
+  suil_mutex_unlock(&host->mutex);
+
+  SUIL_TRACE_BEGIN(host->trace, "create_instance");
+
+  SuilInstance* const instance =
+    !request->descriptor ? NULL
+                         : create_instance(&request->stats,
+                                           host,
+                                           request->controller,
+                                           request->container_type_uri,
+                                           request->plugin_uri,
+                                           request->ui_uri,
+                                           request->ui_type_uri,
+                                           request->ui_bundle_path,
+                                           request->ui_binary_path,
+                                           request->features,
+                                           request->library,
+                                           request->descriptor);
+
+  SUIL_TRACE_END(host->trace, "create_instance");
+
+  // Drop the preloaded module, the wrapper has its own reference if it's used
+  suil_module_unref(request->module);
+  free(request);
+  return instance;
+}
+
 SUIL_API void
 suil_instance_free(SuilInstance* instance)
 {
   if (instance) {
-    for (unsigned i = 0; instance->features[i]; ++i) {
-      free(instance->features[i]);
-    }
-    free(instance->features);
+    uint64_t t = suil_clock_now();
 
     // Call wrapper free function to destroy widgets and drop references
     if (instance->wrapper && instance->wrapper->free) {
       instance->wrapper->free(instance->wrapper);
     }
 
+    instance->stats.wrapper_free_time = lap(&t);
+
     // Call cleanup to destroy UI (if it still exists at this point)
     if (instance->handle) {
       instance->descriptor->cleanup(instance->handle);
     }
 
-    dylib_close(instance->lib_handle);
+    instance->stats.cleanup_time = lap(&t);
+
+    // Forward any pending writes so the host has the final values
+    suil_controls_flush(&instance->writes, forward_write, instance);
+
+    suil_library_unref(instance->library);
+    suil_queue_cleanup(&instance->queue);
+    suil_controls_cleanup(&instance->controls);
+    suil_controls_cleanup(&instance->writes);
 
     // Close libraries and free everything
     if (instance->wrapper) {
-#ifndef _WIN32
-      // Never unload modules on windows, causes mysterious segfaults
-      dylib_close(instance->wrapper->lib);
-#endif
+      suil_module_unref(instance->wrapper->module);
       free(instance->wrapper);
     }
 
+    instance->stats.unload_time = lap(&t);
+    if (instance->stats_func) {
+      instance->stats_func(
+        instance->stats_data, instance->controller, &instance->stats);
+    }
+
     free(instance);
   }
 }
 
+SUIL_API SuilInstanceStats
+suil_instance_get_stats(const SuilInstance* instance)
+{
+  return instance->stats;
+}
+
 SUIL_API SuilHandle
 suil_instance_get_handle(SuilInstance* instance)
 {
@@ -312,6 +730,57 @@ suil_instance_get_widget(SuilInstance* instance)
   return instance->host_widget;
 }
 
+/// Store a control value to be delivered by the next flush, if possible
+static bool
+store_control(SuilInstance* const instance,
+              const uint32_t      port_index,
+              const uint32_t      buffer_size,
+              const uint32_t      format,
+              const void* const   buffer)
+{
+  if (format || buffer_size != sizeof(float)) {
+    return false;
+  }
+
+  float value = 0.0f;
+  memcpy(&value, buffer, sizeof(value));
+  return !suil_controls_set(&instance->controls, port_index, value);
+}
+
+/// Deliver a port event to the UI, or store it if it's a coalesced control
+static void
+deliver_port_event(void* const       data,
+                   const uint32_t    port_index,
+                   const uint32_t    buffer_size,
+                   const uint32_t    format,
+                   const void* const buffer)
+{
+  SuilInstance* const           instance   = (SuilInstance*)data;
+  const LV2UI_Descriptor* const descriptor = instance->descriptor;
+  if (!descriptor->port_event ||
+      (instance->coalesce_controls &&
+       store_control(instance, port_index, buffer_size, format, buffer))) {
+    return;
+  }
+
+  SUIL_TRACE_BEGIN(instance->trace, "port_event");
+  descriptor->port_event(
+    instance->handle, port_index, buffer_size, format, buffer);
+  SUIL_TRACE_END(instance->trace, "port_event");
+}
+
+/// Deliver the latest value of a coalesced control to the UI
+static void
+deliver_control(void* const data, const uint32_t index, const float value)
+{
+  SuilInstance* const instance = (SuilInstance*)data;
+
+  SUIL_TRACE_BEGIN(instance->trace, "port_event");
+  instance->descriptor->port_event(
+    instance->handle, index, sizeof(float), 0U, &value);
+  SUIL_TRACE_END(instance->trace, "port_event");
+}
+
 SUIL_API void
 suil_instance_port_event(SuilInstance* instance,
                          uint32_t      port_index,
@@ -319,10 +788,68 @@ suil_instance_port_event(SuilInstance* instance,
                          uint32_t      format,
                          const void*   buffer)
 {
-  if (instance->descriptor->port_event) {
-    instance->descriptor->port_event(
-      instance->handle, port_index, buffer_size, format, buffer);
+  deliver_port_event(instance, port_index, buffer_size, format, buffer);
+}
+
+SUIL_API void
+suil_instance_port_events(SuilInstance* const        instance,
+                          const SuilPortEvent* const events,
+                          const size_t               n_events)
+{
+  const SuilPortEventFunc port_event = instance->descriptor->port_event;
+  if (!port_event || !n_events) {
+    return;
+  }
+
+  const LV2UI_Handle handle   = instance->handle;
+  const bool         coalesce = instance->coalesce_controls;
+
+  SUIL_TRACE_BEGIN(instance->trace, "port_events");
+  for (size_t i = 0U; i < n_events; ++i) {
+    const SuilPortEvent* const e = &events[i];
+    if (!coalesce ||
+        !store_control(
+          instance, e->port_index, e->buffer_size, e->format, e->buffer)) {
+      port_event(handle, e->port_index, e->buffer_size, e->format, e->buffer);
+    }
   }
+  SUIL_TRACE_END(instance->trace, "port_events");
+}
+
+SUIL_API int
+suil_instance_enqueue_port_event(SuilInstance* const instance,
+                                 const uint32_t      port_index,
+                                 const uint32_t      buffer_size,
+                                 const uint32_t      format,
+                                 const void* const   buffer)
+{
+  return suil_queue_write(
+    &instance->queue, port_index, buffer_size, format, buffer);
+}
+
+SUIL_API int
+suil_instance_enqueue_buffer_event(SuilInstance* const instance,
+                                   const uint32_t      port_index,
+                                   const uint32_t      buffer_size,
+                                   const uint32_t      format,
+                                   SuilBuffer* const   buffer)
+{
+  if (buffer_size > buffer->size) {
+    return 1;
+  }
+
+  return suil_queue_write_buffer(
+    &instance->queue, port_index, buffer_size, format, buffer);
+}
+
+SUIL_API void
+suil_instance_flush(SuilInstance* const instance)
+{
+  SUIL_TRACE_BEGIN(instance->trace, "flush");
+  suil_queue_drain(&instance->queue, deliver_port_event, instance);
+  suil_controls_flush(&instance->controls, deliver_control, instance);
+  suil_controls_flush(&instance->writes, forward_write, instance);
+  SUIL_TRACE_END(instance->trace, "flush");
 }
 
 SUIL_API const void*
@@ -0,0 +1,266 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#include "dylib.h"
+#include "suil_internal.h"
+#include "thread.h"
+
+#include <lv2/ui/ui.h>
+#include <suil/suil.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Return a new reference to a cached library, or null, with the host locked
+static SuilLibrary*
+find_library(SuilHost* const   host,
+             const char* const path,
+             const uint32_t    path_hash)
+{
+  for (SuilLibrary* l = host->libraries; l; l = l->next) {
+    if (l->path_hash == path_hash && !strcmp(l->path, path)) {
+      ++l->refs;
+      ++host->cache_stats.library_hits;
+      return l;
+    }
+  }
+
+  return NULL;
+}
+
+SuilLibrary*
+suil_host_get_library(SuilHost* const host, const char* const path)
+{
+  // Return the cached library if it is already loaded
+  const uint32_t path_hash = suil_hash(path);
+  suil_mutex_lock(&host->mutex);
+  SuilLibrary* const cached = find_library(host, path, path_hash);
+  suil_mutex_unlock(&host->mutex);
+  if (cached) {
+    return cached;
+  }
+
+  // Open UI library without holding the lock, since this can be slow
+  dylib_error();
+  void* const lib = dylib_open(path, DYLIB_NOW);
+  if (!lib) {
+    SUIL_ERRORF("Unable to open UI library %s (%s)\n", path, dylib_error());
+    return NULL;
+  }
+
+  // Get discovery function
+  const LV2UI_DescriptorFunction df =
+    (LV2UI_DescriptorFunction)suil_dlfunc(lib, "lv2ui_descriptor");
+  if (!df) {
+    SUIL_ERRORF("Broken LV2 UI %s (no lv2ui_descriptor symbol found)\n", path);
+    dylib_close(lib);
+    return NULL;
+  }
+
+  const size_t       path_len  = strlen(path);
+  SuilLibrary* const library   = (SuilLibrary*)calloc(1, sizeof(SuilLibrary));
+  char* const        path_copy = (char*)malloc(path_len + 1U);
+  if (!library || !path_copy) {
+    free(path_copy);
+    free(library);
+    dylib_close(lib);
+    return NULL;
+  }
+
+  memcpy(path_copy, path, path_len + 1U);
+
+  // Use the cached library instead if another thread loaded it meanwhile
+  suil_mutex_lock(&host->mutex);
+  SuilLibrary* const loaded = find_library(host, path, path_hash);
+  if (loaded) {
+    suil_mutex_unlock(&host->mutex);
+    free(path_copy);
+    free(library);
+    dylib_close(lib); // Only drops the extra reference held by the loader
+    return loaded;
+  }
+
+  library->next            = host->libraries;
+  library->host            = host;
+  library->path            = path_copy;
+  library->path_hash       = path_hash;
+  library->lib             = lib;
+  library->descriptor_func = df;
+  library->refs            = 1U;
+  host->libraries          = library;
+
+  ++host->cache_stats.library_misses;
+  suil_mutex_unlock(&host->mutex);
+  return library;
+}
+
+/// Return the index slot for `uri`, which is either empty or matches
+static uint32_t*
+find_slot(const SuilLibrary* const library,
+          const char* const        uri,
+          const uint32_t           hash)
+{
+  const uint32_t mask = library->n_slots - 1U;
+  for (uint32_t s = hash & mask;; s = (s + 1U) & mask) {
+    uint32_t* const slot = &library->slots[s];
+    if (!*slot || (library->hashes[*slot - 1U] == hash &&
+                   !strcmp(library->descriptors[*slot - 1U]->URI, uri))) {
+      return slot;
+    }
+  }
+}
+
+/// Build an index of every descriptor in a library, keyed by URI
+static int
+build_index(SuilLibrary* const library)
+{
+  const LV2UI_DescriptorFunction df = library->descriptor_func;
+
+  // Count descriptors and allocate space for the index
+  uint32_t n_descriptors = 0U;
+  while (df(n_descriptors)) {
+    ++n_descriptors;
+  }
+
+  uint32_t n_slots = 4U;
+  while (n_slots < 2U * n_descriptors) {
+    n_slots *= 2U;
+  }
+
+  const size_t descriptors_size = n_descriptors * sizeof(LV2UI_Descriptor*);
+  const size_t hashes_size      = n_descriptors * sizeof(uint32_t);
+  const size_t slots_size       = n_slots * sizeof(uint32_t);
+  const size_t index_size       = descriptors_size + hashes_size + slots_size;
+  char* const  index            = (char*)calloc(1, index_size);
+  if (!index) {
+    return 1;
+  }
+
+  library->descriptors   = (const LV2UI_Descriptor**)index;
+  library->hashes        = (uint32_t*)(index + descriptors_size);
+  library->slots         = (uint32_t*)(index + descriptors_size + hashes_size);
+  library->n_descriptors = n_descriptors;
+  library->n_slots       = n_slots;
+
+  // Insert every descriptor, where the first wins if URIs are duplicated
+  for (uint32_t i = 0U; i < n_descriptors; ++i) {
+    const LV2UI_Descriptor* const descriptor = df(i);
+    const uint32_t                hash       = suil_hash(descriptor->URI);
+
+    library->descriptors[i] = descriptor;
+    library->hashes[i]      = hash;
+
+    uint32_t* const slot = find_slot(library, descriptor->URI, hash);
+    if (!*slot) {
+      *slot = i + 1U;
+    }
+  }
+
+  return 0;
+}
+
+/// Lock the host of a library, if it still has one
+static void
+lock_host(const SuilLibrary* const library)
+{
+  if (library->host) {
+    suil_mutex_lock(&library->host->mutex);
+  }
+}
+
+/// Unlock the host of a library, if it still has one
+static void
+unlock_host(const SuilLibrary* const library)
+{
+  if (library->host) {
+    suil_mutex_unlock(&library->host->mutex);
+  }
+}
+
+const LV2UI_Descriptor*
+suil_library_get_descriptor(SuilLibrary* const library, const char* const uri)
+{
+  SuilHost* const host = library->host;
+
+  // Index the library the first time it is searched
+  lock_host(library);
+  const bool indexed = library->slots != NULL;
+  if (!indexed && build_index(library)) {
+    unlock_host(library);
+    return NULL;
+  }
+
+  const uint32_t* const         slot = find_slot(library, uri, suil_hash(uri));
+  const LV2UI_Descriptor* const descriptor =
+    *slot ? library->descriptors[*slot - 1U] : NULL;
+
+  // Only count a hit if the descriptor was found without indexing
+  if (host && indexed && descriptor) {
+    ++host->cache_stats.descriptor_hits;
+  } else if (host) {
+    ++host->cache_stats.descriptor_misses;
+  }
+
+  unlock_host(library);
+  return descriptor;
+}
+
+SUIL_API int
+suil_library_list_uis(SuilHost* const   host,
+                      const char* const ui_binary_path,
+                      const SuilUIFunc  func,
+                      void* const       data)
+{
+  SuilLibrary* const library = suil_host_get_library(host, ui_binary_path);
+  if (!library) {
+    return 1;
+  }
+
+  lock_host(library);
+  const int st = library->slots ? 0 : build_index(library);
+  unlock_host(library);
+  if (st) {
+    suil_library_unref(library);
+    return 1;
+  }
+
+  for (uint32_t i = 0U; i < library->n_descriptors; ++i) {
+    func(data, library->descriptors[i]->URI);
+  }
+
+  suil_library_unref(library);
+  return 0;
+}
+
+void
+suil_library_unref(SuilLibrary* const library)
+{
+  if (!library) {
+    return;
+  }
+
+  lock_host(library);
+  if (--library->refs) {
+    unlock_host(library);
+    return;
+  }
+
+  // Remove from the host cache if the host still exists
+  if (library->host) {
+    SuilLibrary** l = &library->host->libraries;
+    while (*l != library) {
+      l = &(*l)->next;
+    }
+
+    *l = library->next;
+  }
+
+  unlock_host(library);
+
+  dylib_close(library->lib);
+  free((void*)library->descriptors); // Also hashes and slots
+  free(library->path);
+  free(library);
+}
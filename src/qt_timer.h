@@ -0,0 +1,41 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#ifndef SUIL_QT_TIMER_H
+#define SUIL_QT_TIMER_H
+
+#include "scheduler.h"
+#include "warnings.h"
+
+SUIL_DISABLE_QT_WARNINGS
+#include <QObject>
+#include <QTimer>
+#include <Qt>
+SUIL_RESTORE_WARNINGS
+
+/// Start a QTimer to drive a scheduler (a SuilTimerStartFunc)
+static inline void*
+suil_qt_start_timer(SuilScheduler* const scheduler)
+{
+  auto* const timer = new QTimer();
+
+  // A single timer runs every UI, so precision costs little
+  timer->setTimerType(Qt::PreciseTimer);
+  QObject::connect(
+    timer, &QTimer::timeout, [scheduler]() { suil_scheduler_run(scheduler); });
+
+  timer->start(static_cast<int>(suil_scheduler_interval(scheduler)));
+  return timer;
+}
+
+/// Stop a timer started by suil_qt_start_timer() (a SuilTimerStopFunc)
+static inline void
+suil_qt_stop_timer(void* const timer)
+{
+  auto* const qtimer = static_cast<QTimer*>(timer);
+
+  qtimer->stop();
+  qtimer->deleteLater(); // May be called from the timer's own signal
+}
+
+#endif // SUIL_QT_TIMER_H
@@ -0,0 +1,218 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#include "atomic.h"
+#include "suil_internal.h"
+
+#include <suil/suil.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// The type of a record in a queue
+typedef enum {
+  SUIL_RECORD_EVENT,  ///< Event with the payload inline
+  SUIL_RECORD_BUFFER, ///< Event with the payload in a SuilBuffer
+  SUIL_RECORD_SKIP,   ///< Padding to the end of the ring
+} SuilRecordType;
+
+/**
+   The header of a record in a queue.
+
+   Every record is a header followed by its payload, padded to a multiple of
+   the header size so that all headers and payloads are suitably aligned.
+*/
+typedef struct {
+  uint32_t port_index;  ///< Index of the changed port
+  uint32_t buffer_size; ///< Size of payload in bytes
+  uint32_t format;      ///< Format of payload
+  uint32_t type;        ///< Record type (a SuilRecordType)
+} SuilQueueRecord;
+
+/// The payload of a SUIL_RECORD_BUFFER record
+typedef struct {
+  SuilBuffer* buffer; ///< Buffer with a reference held by the queue
+  uint32_t    size;   ///< Size of the event in buffer
+} SuilBufferRecord;
+
+/// Return the total size of a record with the given payload size
+static uint32_t
+record_size(const uint32_t buffer_size)
+{
+  const uint32_t align = (uint32_t)sizeof(SuilQueueRecord);
+
+  return align + ((buffer_size + align - 1U) & ~(align - 1U));
+}
+
+int
+suil_queue_init(SuilQueue* const queue, const uint32_t size)
+{
+  memset(queue, 0, sizeof(SuilQueue));
+  if (!size) {
+    return 0;
+  }
+
+  uint32_t buf_size = 2U * (uint32_t)sizeof(SuilQueueRecord);
+  while (buf_size < size && buf_size < (1U << 30U)) {
+    buf_size *= 2U;
+  }
+
+  if (!(queue->buf = (char*)malloc(buf_size))) {
+    return 1;
+  }
+
+  queue->size = buf_size;
+  return 0;
+}
+
+void
+suil_queue_cleanup(SuilQueue* const queue)
+{
+  suil_queue_drain(queue, NULL, NULL); // Drop any buffer references
+  free(queue->buf);
+  queue->buf = NULL;
+}
+
+/**
+   Reserve a contiguous record in the ring.
+
+   @param queue Queue to write to.
+   @param buffer_size Size of the record payload.
+   @param[out] length Set to the number of bytes to commit.
+   @return The record to write, or null if there isn't enough space.
+*/
+static SuilQueueRecord*
+reserve(SuilQueue* const queue,
+        const uint32_t   buffer_size,
+        uint32_t* const  length)
+{
+  const uint32_t size = queue->size;
+  if (!size || buffer_size > size - (uint32_t)sizeof(SuilQueueRecord)) {
+    return NULL; // Queue is disabled, or the event could never fit
+  }
+
+  const uint32_t read   = suil_atomic_load(&queue->read_head);
+  const uint32_t write  = queue->write_head;
+  const uint32_t space  = size - (write - read);
+  const uint32_t offset = write & (size - 1U);
+  const uint32_t to_end = size - offset;
+  const uint32_t needed = record_size(buffer_size);
+
+  // Pad to the end of the ring if the record doesn't fit contiguously
+  const uint32_t skip = (needed > to_end) ? to_end : 0U;
+  if (skip + needed > space) {
+    return NULL;
+  }
+
+  if (skip) {
+    SuilQueueRecord* const padding = (SuilQueueRecord*)(queue->buf + offset);
+
+    padding->buffer_size = skip - (uint32_t)sizeof(SuilQueueRecord);
+    padding->type        = SUIL_RECORD_SKIP;
+  }
+
+  SuilQueueRecord* const record =
+    (SuilQueueRecord*)(queue->buf + ((offset + skip) & (size - 1U)));
+
+  record->buffer_size = buffer_size;
+  *length             = skip + needed;
+  return record;
+}
+
+/// Publish a reserved record to the reader
+static void
+commit(SuilQueue* const queue, const uint32_t length)
+{
+  suil_atomic_store(&queue->write_head, queue->write_head + length);
+}
+
+int
+suil_queue_write(SuilQueue* const  queue,
+                 const uint32_t    port_index,
+                 const uint32_t    buffer_size,
+                 const uint32_t    format,
+                 const void* const buffer)
+{
+  uint32_t               length = 0U;
+  SuilQueueRecord* const record = reserve(queue, buffer_size, &length);
+  if (!record) {
+    return 1;
+  }
+
+  record->port_index = port_index;
+  record->format     = format;
+  record->type       = SUIL_RECORD_EVENT;
+  memcpy(record + 1, buffer, buffer_size);
+
+  commit(queue, length);
+  return 0;
+}
+
+int
+suil_queue_write_buffer(SuilQueue* const  queue,
+                        const uint32_t    port_index,
+                        const uint32_t    buffer_size,
+                        const uint32_t    format,
+                        SuilBuffer* const buffer)
+{
+  uint32_t               length = 0U;
+  SuilQueueRecord* const record =
+    reserve(queue, (uint32_t)sizeof(SuilBufferRecord), &length);
+  if (!record) {
+    return 1;
+  }
+
+  SuilBufferRecord* const payload = (SuilBufferRecord*)(record + 1);
+
+  record->port_index = port_index;
+  record->format     = format;
+  record->type       = SUIL_RECORD_BUFFER;
+  payload->buffer    = buffer;
+  payload->size      = buffer_size;
+
+  suil_buffer_ref(buffer);
+  commit(queue, length);
+  return 0;
+}
+
+void
+suil_queue_drain(SuilQueue* const        queue,
+                 const SuilPortEventFunc func,
+                 void* const             data)
+{
+  const uint32_t mask  = queue->size - 1U;
+  const uint32_t write = suil_atomic_load(&queue->write_head);
+  uint32_t       read  = queue->read_head;
+
+  // Deliver only the records written before now, so this always terminates
+  while (read != write) {
+    const SuilQueueRecord* const record =
+      (const SuilQueueRecord*)(queue->buf + (read & mask));
+
+    if (record->type == SUIL_RECORD_EVENT && func) {
+      func(data,
+           record->port_index,
+           record->buffer_size,
+           record->format,
+           record + 1);
+    } else if (record->type == SUIL_RECORD_BUFFER) {
+      const SuilBufferRecord* const payload =
+        (const SuilBufferRecord*)(record + 1);
+
+      if (func) {
+        func(data,
+             record->port_index,
+             payload->size,
+             record->format,
+             suil_buffer_get_data(payload->buffer));
+      }
+
+      suil_buffer_unref(payload->buffer);
+    }
+
+    // Release the space to the writer
+    read += record_size(record->buffer_size);
+    suil_atomic_store(&queue->read_head, read);
+  }
+}
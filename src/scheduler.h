@@ -0,0 +1,351 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#ifndef SUIL_SCHEDULER_H
+#define SUIL_SCHEDULER_H
+
+#include <suil/suil.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Default number of scheduler frames per second
+#define SUIL_FRAME_RATE 60U
+
+/// Default UI update rate in Hz, if the host doesn't set ui:updateRate
+#define SUIL_DEFAULT_UPDATE_RATE 30.0f
+
+/// Update rate in Hz of UIs that can't be seen, to keep them alive
+#define SUIL_HIDDEN_UPDATE_RATE 1.0f
+
+/// Maximum factor the update rate of a slow UI is divided by
+#define SUIL_MAX_THROTTLE 64U
+
+/// Number of calls to wait for the average to settle after throttling
+#define SUIL_THROTTLE_SETTLE 8U
+
+struct SuilSchedulerImpl;
+
+/// A function called by a scheduler every few frames
+typedef void (*SuilFrameFunc)(void* data);
+
+/// Start a toolkit timer that calls suil_scheduler_run() every frame
+typedef void* (*SuilTimerStartFunc)(struct SuilSchedulerImpl* scheduler);
+
+/// Stop a timer returned by a SuilTimerStartFunc
+typedef void (*SuilTimerStopFunc)(void* timer);
+
+/// Return the current time in nanoseconds
+typedef uint64_t (*SuilClockFunc)(void);
+
+/**
+   A function registered with a scheduler.
+
+   Entries are embedded in wrappers, so registering one doesn't allocate.
+*/
+typedef struct SuilFrameEntryImpl {
+  struct SuilFrameEntryImpl* next;      ///< Next entry in scheduler
+  struct SuilSchedulerImpl*  scheduler; ///< Scheduler, or null if removed
+  SuilFrameFunc              func;      ///< Function to call
+  void*                      data;      ///< Passed to func
+  SuilController             owner;     ///< Controller of instance
+  SuilIdleStats              stats;     ///< Call times and throttle factor
+  uint32_t                   settle;    ///< Calls since throttle changed
+  uint32_t                   base;      ///< Frames between calls if visible
+  uint32_t                   divisor;   ///< Frames between calls
+  bool                       hidden;    ///< True if the UI can't be seen
+  bool                       due;       ///< Call on the next frame regardless
+} SuilFrameEntry;
+
+/**
+   A scheduler that runs every wrapper's idle function from a single timer.
+
+   Rather than a timer for every instance, wrappers register with the host's
+   scheduler, which calls every function that is due each frame.  Each entry
+   runs on the divisor of the frame rate that best matches the UI's update
+   rate, and entries with the same divisor always run in the same frame, so
+   any number of UIs only need one wakeup.
+
+   The timer is started by the first wrapper that registers, using the
+   functions for its toolkit, and stopped when the last entry is removed.  The
+   host and every entry hold a reference, so the scheduler outlives the host
+   while any wrapper is still registered.  Everything here runs in the UI
+   thread.  Wrapper modules can't call the hidden internals of libsuil, so
+   this is all inline, and the clock is passed in by the host.
+*/
+typedef struct SuilSchedulerImpl {
+  SuilFrameEntry*      entries;       ///< Registered entries
+  SuilFrameEntry*      next_entry;    ///< Next entry to run in run()
+  void*                timer;         ///< Running timer, or null
+  SuilTimerStopFunc    stop_timer;    ///< Function to stop timer
+  SuilClockFunc        now;           ///< Clock for timing calls, or null
+  SuilIdleWatchdogFunc watchdog;      ///< Called when throttle changes
+  void*                watchdog_data; ///< Passed to watchdog
+  uint64_t             budget;        ///< Maximum average call time, or zero
+  uint32_t             rate;          ///< Frames per second
+  uint32_t             frame;         ///< Number of frames run so far
+  uint32_t             refs;          ///< Reference count
+} SuilScheduler;
+
+/** Return the nearest period of a scheduler's frames in milliseconds. */
+static inline uint32_t
+suil_scheduler_interval(const SuilScheduler* const scheduler)
+{
+  const uint32_t interval = (1000U + (scheduler->rate / 2U)) / scheduler->rate;
+
+  return interval ? interval : 1U;
+}
+
+/** Return the current time of a scheduler's clock in nanoseconds, or zero. */
+static inline uint64_t
+suil_scheduler_now(const SuilScheduler* const scheduler)
+{
+  return scheduler->now ? scheduler->now() : 0U;
+}
+
+/**
+   Return the number of milliseconds until a frame has passed since `last`.
+
+   This is used to do things like resizing at most once per frame, where
+   `last` is the time it was last done.  Zero means that it can be done now.
+*/
+static inline uint32_t
+suil_scheduler_delay(const SuilScheduler* const scheduler, const uint64_t last)
+{
+  const uint64_t period  = 1000000000U / scheduler->rate;
+  const uint64_t elapsed = suil_scheduler_now(scheduler) - last;
+
+  return (!scheduler->now || elapsed >= period)
+           ? 0U
+           : (uint32_t)((period - elapsed + 999999U) / 1000000U);
+}
+
+/** Return the number of frames between calls at an update rate in Hz. */
+static inline uint32_t
+suil_scheduler_divisor(const SuilScheduler* const scheduler,
+                       const float                update_rate)
+{
+  const float max     = (float)UINT16_MAX;
+  const float divisor = update_rate > 0.0f
+                          ? ((float)scheduler->rate / update_rate) + 0.5f
+                          : 1.0f;
+
+  return divisor < 1.0f ? 1U : divisor > max ? UINT16_MAX : (uint32_t)divisor;
+}
+
+/// Set the divisor of a registered entry from its rate, visibility, and speed
+static inline void
+suil_scheduler_update(SuilFrameEntry* const entry)
+{
+  const uint32_t hidden =
+    suil_scheduler_divisor(entry->scheduler, SUIL_HIDDEN_UPDATE_RATE);
+
+  const uint64_t throttled = (uint64_t)entry->base * entry->stats.throttle;
+  const uint32_t divisor =
+    throttled > UINT16_MAX ? UINT16_MAX : (uint32_t)throttled;
+
+  entry->divisor = (entry->hidden && hidden > divisor) ? hidden : divisor;
+}
+
+/** Drop a reference to a scheduler, and free it if it is no longer used. */
+static inline void
+suil_scheduler_unref(SuilScheduler* const scheduler)
+{
+  if (!--scheduler->refs) {
+    free(scheduler);
+  }
+}
+
+/**
+   Register a function to be called at about `update_rate` times per second.
+
+   If the scheduler isn't already running, then `start_timer` is called to
+   start a timer for it, which will be stopped by calling `stop_timer`.  The
+   `owner` is the controller of the instance, passed to the watchdog.
+
+   The entry must be zeroed before it is first added.  An entry that is
+   removed and added again keeps its throttle, so a slow UI isn't sped up
+   (without the watchdog knowing) just because it was unmapped.
+*/
+static inline void
+suil_scheduler_add(SuilScheduler* const     scheduler,
+                   SuilFrameEntry* const    entry,
+                   const SuilController     owner,
+                   const SuilFrameFunc      func,
+                   void* const              data,
+                   const float              update_rate,
+                   const SuilTimerStartFunc start_timer,
+                   const SuilTimerStopFunc  stop_timer)
+{
+  if (!entry->stats.throttle) {
+    entry->stats.throttle = 1U; // First registration, start at full rate
+  }
+
+  entry->next        = scheduler->entries;
+  entry->scheduler   = scheduler;
+  entry->func        = func;
+  entry->data        = data;
+  entry->owner       = owner;
+  entry->base        = suil_scheduler_divisor(scheduler, update_rate);
+  scheduler->entries = entry;
+  ++scheduler->refs;
+  suil_scheduler_update(entry);
+
+  if (!scheduler->timer) {
+    scheduler->timer      = start_timer(scheduler);
+    scheduler->stop_timer = stop_timer;
+  }
+}
+
+/**
+   Remove an entry from its scheduler if it is registered.
+
+   This may be called from within the entry's own function.
+*/
+static inline void
+suil_scheduler_remove(SuilFrameEntry* const entry)
+{
+  SuilScheduler* const scheduler = entry->scheduler;
+  if (!scheduler) {
+    return;
+  }
+
+  for (SuilFrameEntry** e = &scheduler->entries; *e; e = &(*e)->next) {
+    if (*e == entry) {
+      *e = entry->next;
+      break;
+    }
+  }
+
+  if (scheduler->next_entry == entry) {
+    scheduler->next_entry = entry->next;
+  }
+
+  if (!scheduler->entries && scheduler->timer) {
+    scheduler->stop_timer(scheduler->timer);
+    scheduler->timer = NULL;
+  }
+
+  entry->scheduler = NULL;
+  suil_scheduler_unref(scheduler);
+}
+
+/**
+   Set whether the UI of an entry can be seen.
+
+   While an entry is hidden, it runs at SUIL_HIDDEN_UPDATE_RATE, which keeps
+   the UI alive and its port event queue drained without updating it at full
+   rate.  When it is shown again, it runs on the next frame and at its normal
+   rate afterwards.  This may be called whether or not the entry is
+   registered.  Entries are visible by default.
+*/
+static inline void
+suil_scheduler_set_visible(SuilFrameEntry* const entry, const bool visible)
+{
+  if (entry->hidden != visible) {
+    return;
+  }
+
+  entry->hidden = !visible;
+  entry->due    = visible;
+  if (entry->scheduler) {
+    suil_scheduler_update(entry);
+  }
+}
+
+/**
+   Record the time taken by a call to an entry's function.
+
+   This updates the statistics of the entry, and if the scheduler has a
+   budget, throttles the entry when its average goes over it, or lets it
+   recover when its average is well under it.  The throttle only changes by a
+   factor of two at a time, and not until the average has had time to settle.
+*/
+static inline void
+suil_scheduler_measure(SuilScheduler* const  scheduler,
+                       SuilFrameEntry* const entry,
+                       const uint64_t        time)
+{
+  SuilIdleStats* const stats = &entry->stats;
+
+  // Update exponential moving average (weighted 1/8) and maximum
+  const uint64_t average = stats->average_time;
+  stats->average_time = average ? average - (average / 8U) + (time / 8U) : time;
+
+  if (time > stats->max_time) {
+    stats->max_time = time;
+  }
+
+  if (!scheduler->budget || ++entry->settle < SUIL_THROTTLE_SETTLE) {
+    return;
+  }
+
+  const uint32_t old_throttle = stats->throttle;
+  if (stats->average_time > scheduler->budget &&
+      stats->throttle < SUIL_MAX_THROTTLE) {
+    stats->throttle *= 2U;
+  } else if (stats->average_time < scheduler->budget / 2U &&
+             stats->throttle > 1U) {
+    stats->throttle /= 2U;
+  }
+
+  entry->settle = SUIL_THROTTLE_SETTLE;
+  if (stats->throttle != old_throttle) {
+    entry->settle = 0U;
+    if (entry->scheduler) {
+      suil_scheduler_update(entry);
+    }
+
+    if (scheduler->watchdog) {
+      scheduler->watchdog(scheduler->watchdog_data, entry->owner, stats);
+    }
+  }
+}
+
+/**
+   Call the function of an entry, and time it if the scheduler has a clock.
+
+   The entry may be removed by its function, but must not be freed.
+*/
+static inline void
+suil_scheduler_call(SuilScheduler* const scheduler, SuilFrameEntry* const entry)
+{
+  if (!scheduler->now) {
+    entry->func(entry->data);
+    return;
+  }
+
+  const uint64_t start = scheduler->now();
+  entry->func(entry->data);
+  suil_scheduler_measure(scheduler, entry, scheduler->now() - start);
+}
+
+/** Run a frame by calling every function that is due, called by the timer. */
+static inline void
+suil_scheduler_run(SuilScheduler* const scheduler)
+{
+  const uint32_t frame = scheduler->frame++;
+
+  ++scheduler->refs; // Functions may remove the last entries
+  for (SuilFrameEntry* e = scheduler->entries; e; e = scheduler->next_entry) {
+    scheduler->next_entry = e->next;
+    if (e->due || !(frame % e->divisor)) {
+      e->due = false;
+      suil_scheduler_call(scheduler, e);
+    }
+  }
+
+  scheduler->next_entry = NULL;
+  suil_scheduler_unref(scheduler);
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif // SUIL_SCHEDULER_H
@@ -39,6 +39,12 @@
   if the build system defines them all.
 */
 
+#ifdef HAVE_TRACE
+#  define USE_TRACE 1
+#else
+#  define USE_TRACE 0
+#endif
+
 #ifdef HAVE_X11
 #  define USE_X11 1
 #else
@@ -5,16 +5,22 @@
 #define SUIL_INTERNAL_H
 
 #include "dylib.h"
+#include "scheduler.h"
 #include "suil_config.h"
+#include "thread.h"
 
 #include <lv2/core/lv2.h>
+#include <lv2/options/options.h>
 #include <lv2/ui/ui.h>
+#include <lv2/urid/urid.h>
 #include <suil/suil.h>
 
 #ifndef _WIN32
 #  include <dlfcn.h>
 #endif
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -25,17 +31,83 @@ extern "C" {
 
 #define SUIL_ERRORF(fmt, ...) fprintf(stderr, "suil error: " fmt, __VA_ARGS__)
 
+/**
+   A trace file of begin and end events in the Chrome trace event format.
+
+   The trace is opened by the library, which sets `event` to its writer.
+   Wrapper modules can't call the hidden internals of libsuil, so they write
+   to the same file through this pointer.
+*/
+typedef struct SuilTraceImpl {
+  void (*event)(struct SuilTraceImpl* trace, char phase, const char* name);
+  SuilMutex     mutex;    ///< Lock for writing to file
+  FILE*         file;     ///< Output file
+  uint64_t      start;    ///< Time when the trace was opened
+  unsigned long pid;      ///< Process ID
+  uint32_t      n_events; ///< Number of events written so far
+} SuilTrace;
+
+/**
+   Open the trace named by the SUIL_TRACE environment variable.
+
+   The trace is opened once for the whole process and closed at exit.  This
+   returns null if tracing is disabled, or wasn't requested.
+*/
+SuilTrace*
+suil_trace_open(void);
+
+/// Write an event to a trace if it isn't null
+static inline void
+suil_trace_event(SuilTrace* const  trace,
+                 const char        phase,
+                 const char* const name)
+{
+  if (trace) {
+    trace->event(trace, phase, name);
+  }
+}
+
+#if USE_TRACE
+#  define SUIL_TRACE_BEGIN(trace, name) suil_trace_event((trace), 'B', (name))
+#  define SUIL_TRACE_END(trace, name) suil_trace_event((trace), 'E', (name))
+#else
+#  define SUIL_TRACE_BEGIN(trace, name) ((void)(trace))
+#  define SUIL_TRACE_END(trace, name) ((void)(trace))
+#endif
+
 struct SuilHostImpl {
+  SuilMutex               mutex;
+  SuilTrace*              trace;
+  SuilScheduler*          scheduler;
   SuilPortWriteFunc       write_func;
   SuilPortIndexFunc       index_func;
   SuilPortSubscribeFunc   subscribe_func;
   SuilPortUnsubscribeFunc unsubscribe_func;
   SuilTouchFunc           touch_func;
+  struct SuilModuleImpl*  modules;
+  struct SuilLibraryImpl* libraries;
+  SuilCacheStats          cache_stats;
+  uint32_t                queue_size;
+  bool                    coalesce_controls;
+  bool                    coalesce_writes;
+  bool                    frame_clock_idle;
+  SuilInstanceStatsFunc   stats_func;
+  void*                   stats_data;
+  SuilThread              preload_thread;
+  bool                    preloading;
+  SuilUIType              preload_type;
+  SuilCond                cond;
+  SuilInstanceRequest*    requests;
+  SuilInstanceRequest*    last_request;
+  SuilThread              loader;
+  bool                    loading;
+  bool                    stopping;
   void*                   gtk_lib;
   int                     argc;
   char**                  argv;
 };
 
+struct SuilModuleImpl;
 struct SuilWrapperImpl;
 
 typedef void (*SuilWrapperFreeFunc)(struct SuilWrapperImpl*);
@@ -44,47 +116,222 @@ typedef int (*SuilWrapperWrapFunc)(struct SuilWrapperImpl* wrapper,
                                    SuilInstance*           instance);
 
 typedef struct SuilWrapperImpl {
-  SuilWrapperWrapFunc wrap;
-  SuilWrapperFreeFunc free;
-  void*               lib;
-  void*               impl;
-  LV2UI_Resize        resize;
+  SuilWrapperWrapFunc    wrap;
+  SuilWrapperFreeFunc    free;
+  struct SuilModuleImpl* module;
+  void*                  impl;
+  LV2UI_Resize           resize;
 } SuilWrapper;
 
+/**
+   A loaded UI library.
+
+   Libraries are cached by the host while any instance uses them, so opening
+   another instance of an already loaded UI doesn't need to load the library
+   again.  The first search for a descriptor builds an index of every UI in
+   the library, so later searches are a hash table lookup.
+*/
+typedef struct SuilLibraryImpl {
+  struct SuilLibraryImpl*  next;            ///< Next library in host cache
+  SuilHost*                host;            ///< Host, or null if freed
+  char*                    path;            ///< Path of UI binary
+  uint32_t                 path_hash;       ///< Hash of path
+  void*                    lib;             ///< Library handle
+  LV2UI_DescriptorFunction descriptor_func; ///< Resolved lv2ui_descriptor
+  const LV2UI_Descriptor** descriptors;     ///< Descriptors in library order
+  uint32_t*                hashes;          ///< URI hash of each descriptor
+  uint32_t*                slots;           ///< Hash table of descriptors
+  uint32_t                 n_descriptors;   ///< Size of descriptors and hashes
+  uint32_t                 n_slots;         ///< Size of slots (a power of 2)
+  unsigned                 refs;            ///< Reference count
+} SuilLibrary;
+
+/// Number of features that suil itself may add for an instance
+#define SUIL_N_INSTANCE_FEATURES 3U
+
+/// Number of features that a wrapper module may add for an instance
+#define SUIL_N_WRAPPER_FEATURES 3U
+
+/**
+   A fixed-capacity LV2 feature array.
+
+   All storage is allocated up front along with the instance, so building the
+   array doesn't allocate.  Features are indexed by URI hash so that adding a
+   feature which is already present replaces its data in constant time.
+*/
+typedef struct {
+  LV2_Feature** array;      ///< Null-terminated array for instantiate()
+  LV2_Feature*  storage;    ///< Features pointed to by array
+  uint32_t*     hashes;     ///< URI hash of each feature
+  uint32_t*     slots;      ///< Hash table of features
+  uint32_t      n_features; ///< Number of features in array
+  uint32_t      capacity;   ///< Maximum number of features
+  uint32_t      n_slots;    ///< Size of slots (a power of 2)
+} SuilFeatures;
+
+/// A reference-counted buffer, with the data following in the same allocation
+struct SuilBufferImpl {
+  SuilBufferReleaseFunc release_func; ///< Called when refs drops to zero
+  void*                 release_data; ///< Passed to release_func
+  uint32_t              size;         ///< Size of data in bytes
+  uint32_t              refs;         ///< Reference count (atomic)
+};
+
+/// A function that receives a port event, like LV2UI_Descriptor::port_event
+typedef void (*SuilPortEventFunc)(void*       data,
+                                  uint32_t    port_index,
+                                  uint32_t    buffer_size,
+                                  uint32_t    format,
+                                  const void* buffer);
+
+/**
+   A wait-free single-producer single-consumer queue of port events.
+
+   Events are copied into a ring allocated when the instance is created, so
+   writing never allocates or blocks.  Records never wrap around the end of
+   the ring, so the reader can deliver every payload in place.
+*/
+typedef struct {
+  char*    buf;        ///< Ring of records, or null if disabled
+  uint32_t size;       ///< Size of buf in bytes (a power of 2)
+  uint32_t write_head; ///< Bytes ever written (only set by writer)
+  uint32_t read_head;  ///< Bytes ever read (only set by reader)
+} SuilQueue;
+
+/** Initialize a queue with at least `size` bytes, or disabled if zero. */
+int
+suil_queue_init(SuilQueue* queue, uint32_t size);
+
+/** Free the ring of a queue. */
+void
+suil_queue_cleanup(SuilQueue* queue);
+
+/** Write an event to a queue, or return non-zero if there isn't space. */
+int
+suil_queue_write(SuilQueue*  queue,
+                 uint32_t    port_index,
+                 uint32_t    buffer_size,
+                 uint32_t    format,
+                 const void* buffer);
+
+/** Write a reference to an event in a buffer, or return non-zero if full. */
+int
+suil_queue_write_buffer(SuilQueue*  queue,
+                        uint32_t    port_index,
+                        uint32_t    buffer_size,
+                        uint32_t    format,
+                        SuilBuffer* buffer);
+
+/**
+   Read every event written so far, in order, and pass them to `func`.
+
+   If `func` is null, then events are discarded.
+*/
+void
+suil_queue_drain(SuilQueue* queue, SuilPortEventFunc func, void* data);
+
+/// A function that receives the value of a control port
+typedef void (*SuilControlFunc)(void* data, uint32_t index, float value);
+
+/**
+   The latest values of a set of control ports.
+
+   This stores a value for each port, and a bitset of the ports that have been
+   set since the last flush, so that only the last of many changes to a port
+   is delivered.  The arrays grow as necessary to fit the highest port index.
+*/
+typedef struct {
+  float*    values;  ///< Latest value of each port
+  uint32_t* dirty;   ///< Bitset of ports set since the last flush
+  uint32_t  n_ports; ///< Number of elements in values (a multiple of 32)
+} SuilControls;
+
+/** Set the value of a control, or return non-zero on allocation failure. */
+int
+suil_controls_set(SuilControls* controls, uint32_t index, float value);
+
+/** Pass every control set since the last flush to `func`, in index order. */
+void
+suil_controls_flush(SuilControls* controls, SuilControlFunc func, void* data);
+
+/** Free the arrays of a set of controls. */
+void
+suil_controls_cleanup(SuilControls* controls);
+
 struct SuilInstanceImpl {
-  void*                   lib_handle;
+  SuilLibrary*            library;
   const LV2UI_Descriptor* descriptor;
   LV2UI_Handle            handle;
+  SuilPortWriteFunc       write_func;
+  SuilTouchFunc           touch_func;
   SuilWrapper*            wrapper;
-  LV2_Feature**           features;
+  SuilFeatures            features;
   LV2UI_Port_Map          port_map;
   LV2UI_Port_Subscribe    port_subscribe;
   LV2UI_Touch             touch;
+  SuilQueue               queue;
+  SuilControls            controls;
+  SuilControls            writes;
+  SuilController          controller;
+  bool                    coalesce_controls;
+  bool                    coalesce_writes;
+  SuilInstanceStats       stats;
+  SuilInstanceStatsFunc   stats_func;
+  void*                   stats_data;
+  SuilTrace*              trace;
+  SuilScheduler*          scheduler;
   SuilWidget              ui_widget;
   SuilWidget              host_widget;
 };
 
+/**
+   Return true if a wrapper must call suil_instance_flush() regularly.
+
+   Wrappers flush before calling the UI's idle interface, so they need a timer
+   if either the UI has an idle interface, or this returns true.
+*/
+static inline bool
+suil_instance_needs_flush(const SuilInstance* const instance)
+{
+  return instance->queue.buf || instance->coalesce_controls ||
+         instance->coalesce_writes;
+}
+
 /**
    The type of the suil_wrapper_new entry point in a wrapper module.
 
-   This constructs a SuilWrapper which contains everything necessary
-   to wrap a widget, including a possibly extended features array to
-   be used for instantiating the UI.
+   This constructs a SuilWrapper which contains everything necessary to wrap
+   a widget, and adds any features it implements (at most
+   SUIL_N_WRAPPER_FEATURES) to the features used for instantiating the UI.
 */
-typedef SuilWrapper* (*SuilWrapperNewFunc)(SuilHost*      host,
-                                           const char*    host_type_uri,
-                                           const char*    ui_type_uri,
-                                           LV2_Feature*** features,
-                                           unsigned       n_features);
+typedef SuilWrapper* (*SuilWrapperNewFunc)(SuilHost*     host,
+                                           const char*   host_type_uri,
+                                           const char*   ui_type_uri,
+                                           SuilFeatures* features);
+
+/**
+   A loaded wrapper module.
+
+   Modules are cached by the host so that the library is only loaded and
+   resolved once, no matter how many instances use it.  The host holds one
+   reference for as long as it exists, and each wrapper holds another.  The
+   reference count is atomic, since modules may be loaded by other threads.
+*/
+typedef struct SuilModuleImpl {
+  struct SuilModuleImpl* next;        ///< Next module in host cache
+  const char*            name;        ///< Module name (static string)
+  void*                  lib;         ///< Library handle
+  SuilWrapperNewFunc     wrapper_new; ///< Resolved suil_wrapper_new
+  uint32_t               refs;        ///< Reference count (atomic)
+} SuilModule;
 
 /** Prototype for suil_wrapper_new in each wrapper module. */
 SUIL_LIB_EXPORT
 SuilWrapper*
-suil_wrapper_new(SuilHost*      host,
-                 const char*    host_type_uri,
-                 const char*    ui_type_uri,
-                 LV2_Feature*** features,
-                 unsigned       n_features);
+suil_wrapper_new(SuilHost*     host,
+                 const char*   host_type_uri,
+                 const char*   ui_type_uri,
+                 SuilFeatures* features);
 
 /** Prototype for suil_host_init in each init module. */
 SUIL_LIB_EXPORT
@@ -127,6 +374,56 @@ suil_open_module(const char* module_name)
 #undef N_SLICES
 }
 
+/** Return the name of the module that wraps one UI type in another, or null. */
+const char*
+suil_wrapper_module(SuilUIType container_type, SuilUIType ui_type);
+
+/**
+   Get a reference to the wrapper module with the given name.
+
+   The module is loaded if necessary, otherwise the cached module is returned.
+   The returned reference must be dropped with suil_module_unref().
+*/
+SuilModule*
+suil_host_get_module(SuilHost* host, const char* name);
+
+/** Drop a reference to a module, and unload it if it is no longer used. */
+void
+suil_module_unref(SuilModule* module);
+
+/**
+   Get a reference to the UI library at the given path.
+
+   The library is loaded if necessary, otherwise the cached library is
+   returned.  The returned reference must be dropped with suil_library_unref().
+*/
+SuilLibrary*
+suil_host_get_library(SuilHost* host, const char* path);
+
+/** Return the descriptor for the UI with the given URI, or null. */
+const LV2UI_Descriptor*
+suil_library_get_descriptor(SuilLibrary* library, const char* uri);
+
+/** Drop a reference to a library, and unload it if it is no longer used. */
+void
+suil_library_unref(SuilLibrary* library);
+
+/** Return the current time of a monotonic clock in nanoseconds. */
+uint64_t
+suil_clock_now(void);
+
+/** Return a 32-bit FNV-1a hash of a string. */
+static inline uint32_t
+suil_hash(const char* str)
+{
+  uint32_t h = 2166136261U;
+  for (const char* s = str; *s; ++s) {
+    h = (h ^ (uint8_t)*s) * 16777619U;
+  }
+
+  return h;
+}
+
 typedef void (*SuilVoidFunc)(void);
 
 /** dlsym wrapper to return a function pointer (without annoying warning) */
@@ -142,28 +439,128 @@ suil_dlfunc(void* handle, const char* symbol)
 #endif
 }
 
-/** Add a feature to a (mutable) LV2 feature array. */
+/** Return the size of the storage required for a feature array. */
+static inline size_t
+suil_features_size(const uint32_t capacity, const uint32_t n_slots)
+{
+  return ((capacity + 1U) * sizeof(LV2_Feature*)) +
+         (capacity * sizeof(LV2_Feature)) + (capacity * sizeof(uint32_t)) +
+         (n_slots * sizeof(uint32_t));
+}
+
+/** Return the number of hash table slots for a feature array. */
+static inline uint32_t
+suil_features_n_slots(const uint32_t capacity)
+{
+  uint32_t n_slots = 4U;
+  while (n_slots < 2U * capacity) {
+    n_slots *= 2U;
+  }
+
+  return n_slots;
+}
+
+/**
+   Initialize an empty feature array.
+
+   @param features Feature array to initialize.
+   @param storage Zeroed storage of at least suil_features_size() bytes.
+   @param capacity Maximum number of features.
+   @param n_slots Number of hash table slots from suil_features_n_slots().
+*/
 static inline void
-suil_add_feature(LV2_Feature*** features,
-                 unsigned*      n,
-                 const char*    uri,
-                 void*          data)
+suil_features_init(SuilFeatures* const features,
+                   void* const         storage,
+                   const uint32_t      capacity,
+                   const uint32_t      n_slots)
 {
-  for (unsigned i = 0; i < *n && (*features)[i]; ++i) {
-    if (!strcmp((*features)[i]->URI, uri)) {
-      (*features)[i]->data = data;
-      return;
+  char* const array   = (char*)storage;
+  char* const structs = array + ((capacity + 1U) * sizeof(LV2_Feature*));
+  char* const hashes  = structs + (capacity * sizeof(LV2_Feature));
+  char* const slots   = hashes + (capacity * sizeof(uint32_t));
+
+  features->array      = (LV2_Feature**)array;
+  features->storage    = (LV2_Feature*)structs;
+  features->hashes     = (uint32_t*)hashes;
+  features->slots      = (uint32_t*)slots;
+  features->n_features = 0U;
+  features->capacity   = capacity;
+  features->n_slots    = n_slots;
+}
+
+/** Return the hash table slot for `uri`, which is either empty or matches. */
+static inline uint32_t*
+suil_features_find_slot(const SuilFeatures* const features,
+                        const char* const         uri,
+                        const uint32_t            hash)
+{
+  const uint32_t mask = features->n_slots - 1U;
+  for (uint32_t s = hash & mask;; s = (s + 1U) & mask) {
+    uint32_t* const slot = &features->slots[s];
+    if (!*slot || (features->hashes[*slot - 1U] == hash &&
+                   !strcmp(features->storage[*slot - 1U].URI, uri))) {
+      return slot;
     }
   }
+}
 
-  *features =
-    (LV2_Feature**)realloc(*features, sizeof(LV2_Feature*) * (*n + 2));
+/** Add a feature, or replace its data if it is already present. */
+static inline void
+suil_add_feature(SuilFeatures* const features,
+                 const char* const   uri,
+                 void* const         data)
+{
+  const uint32_t  hash = suil_hash(uri);
+  uint32_t* const slot = suil_features_find_slot(features, uri, hash);
+  if (*slot) {
+    features->storage[*slot - 1U].data = data;
+    return;
+  }
+
+  const uint32_t i = features->n_features;
+  if (i == features->capacity) {
+    SUIL_ERRORF("Too many features, ignoring <%s>\n", uri);
+    return;
+  }
+
+  features->storage[i].URI  = uri;
+  features->storage[i].data = data;
+  features->hashes[i]       = hash;
+  features->array[i]        = &features->storage[i];
+  features->array[i + 1U]   = NULL;
+  features->n_features      = i + 1U;
+  *slot                     = i + 1U;
+}
+
+/** Return the data of the feature with the given URI, or null. */
+static inline void*
+suil_get_feature(const SuilFeatures* const features, const char* const uri)
+{
+  const uint32_t* const slot =
+    suil_features_find_slot(features, uri, suil_hash(uri));
+
+  return *slot ? features->storage[*slot - 1U].data : NULL;
+}
+
+/** Return the UI update rate given in the options feature, or the default. */
+static inline float
+suil_get_update_rate(const SuilFeatures* const features)
+{
+  const LV2_URID_Map* const map =
+    (const LV2_URID_Map*)suil_get_feature(features, LV2_URID__map);
+  const LV2_Options_Option* const options =
+    (const LV2_Options_Option*)suil_get_feature(features, LV2_OPTIONS__options);
+
+  if (map && options) {
+    const LV2_URID ui_updateRate = map->map(map->handle, LV2_UI__updateRate);
+    for (const LV2_Options_Option* o = options; o->key; ++o) {
+      if (o->key == ui_updateRate) {
+        return *(const float*)o->value;
+      }
+    }
+  }
 
-  (*features)[*n]       = (LV2_Feature*)malloc(sizeof(LV2_Feature));
-  (*features)[*n]->URI  = uri;
-  (*features)[*n]->data = data;
-  (*features)[*n + 1]   = NULL;
-  *n += 1;
+  return SUIL_DEFAULT_UPDATE_RATE;
 }
 
 extern int    suil_argc;
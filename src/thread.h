@@ -0,0 +1,229 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#ifndef SUIL_THREAD_H
+#define SUIL_THREAD_H
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#endif
+
+/// A function run in a new thread
+typedef void (*SuilThreadFunc)(void* data);
+
+#ifdef _WIN32
+
+typedef CRITICAL_SECTION SuilMutex;
+
+typedef CONDITION_VARIABLE SuilCond;
+
+typedef INIT_ONCE SuilOnce;
+
+#  define SUIL_ONCE_INIT INIT_ONCE_STATIC_INIT
+
+typedef struct {
+  HANDLE         handle;
+  SuilThreadFunc func;
+  void*          data;
+} SuilThread;
+
+static inline int
+suil_mutex_init(SuilMutex* const mutex)
+{
+  InitializeCriticalSection(mutex);
+  return 0;
+}
+
+static inline void
+suil_mutex_destroy(SuilMutex* const mutex)
+{
+  DeleteCriticalSection(mutex);
+}
+
+static inline void
+suil_mutex_lock(SuilMutex* const mutex)
+{
+  EnterCriticalSection(mutex);
+}
+
+static inline void
+suil_mutex_unlock(SuilMutex* const mutex)
+{
+  LeaveCriticalSection(mutex);
+}
+
+static inline int
+suil_cond_init(SuilCond* const cond)
+{
+  InitializeConditionVariable(cond);
+  return 0;
+}
+
+static inline void
+suil_cond_destroy(SuilCond* const cond)
+{
+  (void)cond;
+}
+
+static inline void
+suil_cond_wait(SuilCond* const cond, SuilMutex* const mutex)
+{
+  SleepConditionVariableCS(cond, mutex, INFINITE);
+}
+
+static inline void
+suil_cond_broadcast(SuilCond* const cond)
+{
+  WakeAllConditionVariable(cond);
+}
+
+static inline BOOL CALLBACK
+suil_once_run(PINIT_ONCE once, PVOID param, PVOID* context)
+{
+  (void)once;
+  (void)context;
+
+  ((void (*)(void))param)();
+  return TRUE;
+}
+
+static inline void
+suil_once(SuilOnce* const once, void (*const func)(void))
+{
+  InitOnceExecuteOnce(once, suil_once_run, (PVOID)func, NULL);
+}
+
+static inline DWORD WINAPI
+suil_thread_run(LPVOID arg)
+{
+  SuilThread* const thread = (SuilThread*)arg;
+  thread->func(thread->data);
+  return 0;
+}
+
+static inline int
+suil_thread_start(SuilThread* const    thread,
+                  const SuilThreadFunc func,
+                  void* const          data)
+{
+  thread->func   = func;
+  thread->data   = data;
+  thread->handle = CreateThread(NULL, 0, suil_thread_run, thread, 0, NULL);
+  return !thread->handle;
+}
+
+static inline void
+suil_thread_join(SuilThread* const thread)
+{
+  WaitForSingleObject(thread->handle, INFINITE);
+  CloseHandle(thread->handle);
+}
+
+#else
+
+typedef pthread_mutex_t SuilMutex;
+
+typedef pthread_cond_t SuilCond;
+
+typedef pthread_once_t SuilOnce;
+
+#  define SUIL_ONCE_INIT PTHREAD_ONCE_INIT
+
+typedef struct {
+  pthread_t      handle;
+  SuilThreadFunc func;
+  void*          data;
+} SuilThread;
+
+static inline int
+suil_mutex_init(SuilMutex* const mutex)
+{
+  return pthread_mutex_init(mutex, NULL);
+}
+
+static inline void
+suil_mutex_destroy(SuilMutex* const mutex)
+{
+  pthread_mutex_destroy(mutex);
+}
+
+static inline void
+suil_mutex_lock(SuilMutex* const mutex)
+{
+  pthread_mutex_lock(mutex);
+}
+
+static inline void
+suil_mutex_unlock(SuilMutex* const mutex)
+{
+  pthread_mutex_unlock(mutex);
+}
+
+static inline int
+suil_cond_init(SuilCond* const cond)
+{
+  return pthread_cond_init(cond, NULL);
+}
+
+static inline void
+suil_cond_destroy(SuilCond* const cond)
+{
+  pthread_cond_destroy(cond);
+}
+
+/// Unlock `mutex` and wait for a broadcast, then lock `mutex` again
+static inline void
+suil_cond_wait(SuilCond* const cond, SuilMutex* const mutex)
+{
+  pthread_cond_wait(cond, mutex);
+}
+
+/// Wake every thread waiting on a condition
+static inline void
+suil_cond_broadcast(SuilCond* const cond)
+{
+  pthread_cond_broadcast(cond);
+}
+
+/// Call `func` exactly once, even if called from several threads at once
+static inline void
+suil_once(SuilOnce* const once, void (*const func)(void))
+{
+  pthread_once(once, func);
+}
+
+static inline void*
+suil_thread_run(void* const arg)
+{
+  SuilThread* const thread = (SuilThread*)arg;
+  thread->func(thread->data);
+  return NULL;
+}
+
+/**
+   Start a thread which calls `func` with `data`.
+
+   The `thread` must remain valid until it is joined.
+*/
+static inline int
+suil_thread_start(SuilThread* const    thread,
+                  const SuilThreadFunc func,
+                  void* const          data)
+{
+  thread->func = func;
+  thread->data = data;
+  return pthread_create(&thread->handle, NULL, suil_thread_run, thread);
+}
+
+/// Wait for a thread to finish
+static inline void
+suil_thread_join(SuilThread* const thread)
+{
+  pthread_join(thread->handle, NULL);
+}
+
+#endif
+
+#endif // SUIL_THREAD_H
@@ -0,0 +1,143 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#define _POSIX_C_SOURCE 200809L // for getpid
+
+#include "suil_config.h"
+#include "suil_internal.h"
+
+#if USE_TRACE
+
+#  include "thread.h"
+
+#  include <errno.h>
+#  include <inttypes.h>
+#  include <stdint.h>
+#  include <stdio.h>
+#  include <stdlib.h>
+#  include <string.h>
+
+#  ifdef _WIN32
+#    include <windows.h>
+#  else
+#    include <pthread.h>
+#    include <unistd.h>
+#  endif
+
+/// The trace for the whole process, shared by every host and instance
+static SuilTrace trace_state;
+
+/// Flag to open the trace only once, even if hosts are created concurrently
+static SuilOnce trace_once = SUIL_ONCE_INIT;
+
+/// True if the trace was opened successfully, never cleared
+static bool trace_opened = false;
+
+static unsigned long
+current_thread_id(void)
+{
+#  ifdef _WIN32
+  return (unsigned long)GetCurrentThreadId();
+#  else
+  return (unsigned long)(uintptr_t)pthread_self();
+#  endif
+}
+
+static void
+trace_event(SuilTrace* const trace, const char phase, const char* const name)
+{
+  const uint64_t time = suil_clock_now() - trace->start;
+  const char*    sep  = ",\n";
+
+  suil_mutex_lock(&trace->mutex);
+  if (!trace->file) {
+    suil_mutex_unlock(&trace->mutex); // Closed at exit
+    return;
+  }
+
+  if (!trace->n_events++) {
+    sep = "";
+  }
+
+  fprintf(trace->file,
+          "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%" PRIu64 ".%03u,"
+          "\"pid\":%lu,\"tid\":%lu}",
+          sep,
+          name,
+          phase,
+          time / 1000U,
+          (unsigned)(time % 1000U),
+          trace->pid,
+          current_thread_id());
+
+  suil_mutex_unlock(&trace->mutex);
+}
+
+/**
+   Close the trace at exit.
+
+   Threads may still write events after this, so the mutex is left alive and
+   the file is cleared under it, which makes later events (and closes) no-ops.
+*/
+static void
+close_trace(void)
+{
+  suil_mutex_lock(&trace_state.mutex);
+  if (trace_state.file) {
+    fputs("\n]\n", trace_state.file);
+    fclose(trace_state.file);
+    trace_state.file = NULL;
+  }
+  suil_mutex_unlock(&trace_state.mutex);
+}
+
+static void
+open_trace(void)
+{
+  const char* const path = getenv("SUIL_TRACE");
+  if (!path || !path[0]) {
+    return;
+  }
+
+  if (suil_mutex_init(&trace_state.mutex)) {
+    return;
+  }
+
+  FILE* const file = fopen(path, "w");
+  if (!file) {
+    SUIL_ERRORF("Failed to open trace file %s (%s)\n", path, strerror(errno));
+    suil_mutex_destroy(&trace_state.mutex);
+    return;
+  }
+
+  trace_state.event    = trace_event;
+  trace_state.file     = file;
+  trace_state.start    = suil_clock_now();
+  trace_state.n_events = 0U;
+#  ifdef _WIN32
+  trace_state.pid = (unsigned long)GetCurrentProcessId();
+#  else
+  trace_state.pid = (unsigned long)getpid();
+#  endif
+
+  fputs("[\n", file);
+  atexit(close_trace);
+  trace_opened = true;
+}
+
+SuilTrace*
+suil_trace_open(void)
+{
+  suil_once(&trace_once, open_trace);
+  return trace_opened ? &trace_state : NULL;
+}
+
+#else
+
+SuilTrace*
+suil_trace_open(void)
+{
+  return NULL;
+}
+
+#endif
@@ -1,12 +1,11 @@
 // Copyright 2011-2021 David Robillard <d@drobilla.net>
 // SPDX-License-Identifier: ISC
 
+#include "glib_timer.h"
+#include "scheduler.h"
 #include "suil_internal.h"
 #include "warnings.h"
 
-#include <lv2/options/options.h>
-#include <lv2/urid/urid.h>
-
 SUIL_DISABLE_GTK_WARNINGS
 #include <gdk/gdkwin32.h>
 #include <gtk/gtk.h>
@@ -19,8 +18,6 @@ SUIL_RESTORE_WARNINGS
 #  define WM_MOUSEHWHEEL 0x020E
 #endif
 
-#include <string.h>
-
 extern "C" {
 
 #define SUIL_TYPE_WIN_WRAPPER (suil_win_wrapper_get_type())
@@ -33,8 +30,8 @@ struct _SuilWinWrapper {
   SuilInstance*               instance;
   GdkWindow*                  flt_win;
   const LV2UI_Idle_Interface* idle_iface;
-  guint                       idle_id;
-  guint                       idle_ms;
+  SuilFrameEntry              frame;
+  float                       update_rate;
 };
 
 struct _SuilWinWrapperClass {
@@ -54,6 +51,7 @@ suil_win_wrapper_finalize(GObject* gobject)
 {
   SuilWinWrapper* const self = SUIL_WIN_WRAPPER(gobject);
 
+  suil_scheduler_remove(&self->frame);
   self->wrapper->impl = nullptr;
   self->instance      = nullptr;
 
@@ -103,18 +101,22 @@ suil_win_wrapper_class_init(SuilWinWrapperClass* klass)
 static void
 suil_win_wrapper_init(SuilWinWrapper* self)
 {
-  self->instance   = nullptr;
-  self->flt_win    = nullptr;
-  self->idle_iface = nullptr;
-  self->idle_ms    = 1000 / 30; // 30 Hz default
+  self->instance    = nullptr;
+  self->flt_win     = nullptr;
+  self->idle_iface  = nullptr;
+  self->update_rate = SUIL_DEFAULT_UPDATE_RATE;
 }
 
-static gboolean
+static void
 suil_win_wrapper_idle(void* data)
 {
   SuilWinWrapper* const wrap = SUIL_WIN_WRAPPER(data);
-  wrap->idle_iface->idle(wrap->instance->handle);
-  return TRUE; // Continue calling
+  SUIL_TRACE_BEGIN(wrap->instance->trace, "idle");
+  suil_instance_flush(wrap->instance);
+  if (wrap->idle_iface) {
+    wrap->idle_iface->idle(wrap->instance->handle);
+  }
+  SUIL_TRACE_END(wrap->instance->trace, "idle");
 }
 
 static int
@@ -139,9 +141,16 @@ wrapper_wrap(SuilWrapper* wrapper, SuilInstance* instance)
       (const LV2UI_Idle_Interface*)instance->descriptor->extension_data(
         LV2_UI__idleInterface);
   }
-  if (idle_iface) {
-    wrap->idle_iface = idle_iface;
-    wrap->idle_id = g_timeout_add(wrap->idle_ms, suil_win_wrapper_idle, wrap);
+  wrap->idle_iface = idle_iface;
+  if (idle_iface || suil_instance_needs_flush(instance)) {
+    suil_scheduler_add(instance->scheduler,
+                       &wrap->frame,
+                       instance->controller,
+                       suil_win_wrapper_idle,
+                       wrap,
+                       wrap->update_rate,
+                       suil_glib_start_timer,
+                       suil_glib_stop_timer);
   }
 
   return 0;
@@ -173,10 +182,7 @@ wrapper_free(SuilWrapper* wrapper)
 {
   if (wrapper->impl) {
     SuilWinWrapper* const wrap = SUIL_WIN_WRAPPER(wrapper->impl);
-    if (wrap->idle_id) {
-      g_source_remove(wrap->idle_id);
-      wrap->idle_id = 0;
-    }
+    suil_scheduler_remove(&wrap->frame);
 
     gdk_window_remove_filter(wrap->flt_win, event_filter, wrapper->impl);
     gtk_object_destroy(GTK_OBJECT(wrap));
@@ -185,18 +191,13 @@ wrapper_free(SuilWrapper* wrapper)
 
 SUIL_LIB_EXPORT
 SuilWrapper*
-suil_wrapper_new(SuilHost*      host,
-                 const char*    host_type_uri,
-                 const char*    ui_type_uri,
-                 LV2_Feature*** features,
-                 unsigned       n_features)
+suil_wrapper_new(SuilHost*     host,
+                 const char*   host_type_uri,
+                 const char*   ui_type_uri,
+                 SuilFeatures* features)
 {
-  GtkWidget* parent = nullptr;
-  for (unsigned i = 0; i < n_features; ++i) {
-    if (!strcmp((*features)[i]->URI, LV2_UI__parent)) {
-      parent = (GtkWidget*)(*features)[i]->data;
-    }
-  }
+  GtkWidget* const parent =
+    (GtkWidget*)suil_get_feature(features, LV2_UI__parent);
 
   if (!GTK_CONTAINER(parent)) {
     SUIL_ERRORF("No GtkContainer parent given for %s UI\n", ui_type_uri);
@@ -227,31 +228,12 @@ suil_wrapper_new(SuilHost*      host,
   gdk_window_add_filter(wrap->flt_win, event_filter, wrap);
 
   HWND parent_window = (HWND)GDK_WINDOW_HWND(window);
-  suil_add_feature(features, &n_features, LV2_UI__parent, parent_window);
-  suil_add_feature(features, &n_features, LV2_UI__resize, &wrapper->resize);
-  suil_add_feature(features, &n_features, LV2_UI__idleInterface, nullptr);
-
-  // Scan for URID map and options
-  LV2_URID_Map*       map     = nullptr;
-  LV2_Options_Option* options = nullptr;
-  for (LV2_Feature** f = *features; *f && (!map || !options); ++f) {
-    if (!strcmp((*f)->URI, LV2_OPTIONS__options)) {
-      options = (LV2_Options_Option*)(*f)->data;
-    } else if (!strcmp((*f)->URI, LV2_URID__map)) {
-      map = (LV2_URID_Map*)(*f)->data;
-    }
-  }
+  suil_add_feature(features, LV2_UI__parent, parent_window);
+  suil_add_feature(features, LV2_UI__resize, &wrapper->resize);
+  suil_add_feature(features, LV2_UI__idleInterface, nullptr);
 
-  if (map && options) {
-    // Set UI update rate if given
-    LV2_URID ui_updateRate = map->map(map->handle, LV2_UI__updateRate);
-    for (LV2_Options_Option* o = options; o->key; ++o) {
-      if (o->key == ui_updateRate) {
-        wrap->idle_ms = 1000.0f / *(const float*)o->value;
-        break;
-      }
-    }
-  }
+  // Set UI update rate if given
+  wrap->update_rate = suil_get_update_rate(features);
 
   return wrapper;
 }
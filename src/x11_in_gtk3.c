@@ -1,14 +1,14 @@
 // Copyright 2011-2021 David Robillard <d@drobilla.net>
 // SPDX-License-Identifier: ISC
 
+#include "glib_timer.h"
+#include "scheduler.h"
 #include "suil_internal.h"
 #include "warnings.h"
 #include "x11_util.h"
 
 #include <lv2/core/lv2.h>
-#include <lv2/options/options.h>
 #include <lv2/ui/ui.h>
-#include <lv2/urid/urid.h>
 #include <suil/suil.h>
 
 #include <X11/X.h>
@@ -33,12 +33,25 @@ SUIL_RESTORE_WARNINGS
 typedef struct {
   GtkSocket                   socket;
   GtkPlug*                    plug;
+  GdkWindow*                  plug_window;
+  SuilX11Child                child;
+  SuilX11Hints                hints;
+  SuilX11Ancestors            ancestors;
   SuilWrapper*                wrapper;
   SuilInstance*               instance;
   const LV2UI_Idle_Interface* idle_iface;
-  guint                       idle_id;
-  guint                       idle_ms;
+  SuilFrameEntry              frame;
+  float                       update_rate;
+  gboolean                    frame_clock_idle;
+  guint                       tick_id;
+  gint64                      last_tick;
+  GtkWidget*                  toplevel;
+  GdkWindowState              toplevel_state;
+  gboolean                    obscured;
   guint                       idle_size_request_id;
+  guint                       resize_id;
+  GtkAllocation               resize_allocation;
+  uint64_t                    last_resize;
   XSizeHints                  size_hints;
   gboolean                    size_hints_dirty;
 } SuilX11Wrapper;
@@ -56,6 +69,22 @@ suil_x11_wrapper_get_type(void); // Accessor for SUIL_TYPE_X11_WRAPPER
 
 G_DEFINE_TYPE(SuilX11Wrapper, suil_x11_wrapper, GTK_TYPE_SOCKET)
 
+/// Wrappers in this module, which share one filter for UI and ancestor events
+static GSList* wrappers = NULL;
+
+/// Wrappers indexed by the UI window that their size hints are read from
+static GHashTable* hint_windows = NULL;
+
+/// Cancel any pending resize
+static void
+cancel_resize(SuilX11Wrapper* const wrap)
+{
+  if (wrap->resize_id) {
+    g_source_remove(wrap->resize_id);
+    wrap->resize_id = 0;
+  }
+}
+
 static gboolean
 on_plug_removed(GtkSocket* sock, gpointer data)
 {
@@ -63,11 +92,14 @@ on_plug_removed(GtkSocket* sock, gpointer data)
 
   SuilX11Wrapper* const self = SUIL_X11_WRAPPER(sock);
 
-  if (self->idle_id) {
-    g_source_remove(self->idle_id);
-    self->idle_id = 0;
+  if (self->tick_id) {
+    gtk_widget_remove_tick_callback(GTK_WIDGET(self), self->tick_id);
+    self->tick_id = 0;
   }
 
+  suil_scheduler_remove(&self->frame);
+  cancel_resize(self);
+
   if (self->idle_size_request_id) {
     g_source_remove(self->idle_size_request_id);
     self->idle_size_request_id = 0;
@@ -82,13 +114,200 @@ on_plug_removed(GtkSocket* sock, gpointer data)
   return TRUE;
 }
 
+static int
+wrapper_resize(LV2UI_Feature_Handle handle, int width, int height)
+{
+  SuilX11Wrapper* const wrap = SUIL_X11_WRAPPER(handle);
+
+  wrap->size_hints.width  = width;
+  wrap->size_hints.height = height;
+  if (width > 0 && height > 0) {
+    wrap->size_hints.flags |= USSize;
+  }
+
+  // Fetch hints to get size constraints (probably) updated by plugin
+  wrap->size_hints_dirty = TRUE;
+
+  gtk_widget_queue_resize(GTK_WIDGET(handle));
+  return 0;
+}
+
+/// Set the drag and drop proxy of the plug window and its ancestors to the UI
+static void
+set_xdnd_proxy(SuilX11Wrapper* const wrap)
+{
+  GdkWindow* const  gwindow  = gtk_widget_get_window(GTK_WIDGET(wrap->plug));
+  GdkWindow* const  parent   = gtk_widget_get_window(GTK_WIDGET(wrap));
+  GdkDisplay* const display  = gdk_window_get_display(gwindow);
+  Display* const    xdisplay = GDK_WINDOW_XDISPLAY(gwindow);
+
+  const Atom   xdnd_proxy_atom = gdk_x11_get_xatom_by_name("XdndProxy");
+  const Window ui_window       = (Window)wrap->instance->ui_widget;
+
+  // Get ancestors, which are only queried again if they may have changed
+  const bool refreshed = suil_x11_ancestors_update(&wrap->ancestors,
+                                                   xdisplay,
+                                                   GDK_WINDOW_XID(gwindow),
+                                                   GDK_WINDOW_XID(parent));
+
+  // Set the proxy on every window without waiting for any replies
+  for (unsigned i = 0U; i < wrap->ancestors.count; ++i) {
+    const Window xwindow = wrap->ancestors.windows[i];
+
+    XChangeProperty(xdisplay,
+                    xwindow,
+                    xdnd_proxy_atom,
+                    XA_WINDOW,
+                    32,
+                    PropModeReplace,
+                    (const unsigned char*)&ui_window,
+                    1);
+
+    // Watch for foreign windows (like window manager frames) being reparented
+    if (refreshed && !gdk_x11_window_lookup_for_display(display, xwindow)) {
+      XSelectInput(xdisplay, xwindow, StructureNotifyMask);
+    }
+  }
+}
+
+/// Start caching the hints of a UI window, and index it for on_window_event()
+static void
+init_hints(SuilX11Wrapper* const wrap,
+           Display* const        display,
+           const Window          window)
+{
+  if (wrap->hints.window) {
+    g_hash_table_remove(hint_windows, GSIZE_TO_POINTER(wrap->hints.window));
+  }
+
+  suil_x11_hints_init(&wrap->hints, display, window);
+  g_hash_table_insert(hint_windows, GSIZE_TO_POINTER(window), wrap);
+}
+
+/// Track the UI window and handle its requests from plug window events
+static GdkFilterReturn
+on_plug_event(GdkXEvent* xevent, GdkEvent* event, gpointer data)
+{
+  (void)event;
+
+  SuilX11Wrapper* const wrap = (SuilX11Wrapper*)data;
+  const XEvent* const   xev  = (const XEvent*)xevent;
+
+  // Handle requests redirected from the UI as soon as they arrive
+  if (xev->type == MapRequest) {
+    XMapWindow(xev->xany.display, xev->xmaprequest.window);
+    return GDK_FILTER_REMOVE;
+  }
+
+  if (xev->type == ConfigureRequest) {
+    wrap->size_hints.flags = 0;
+    wrap->size_hints_dirty = TRUE;
+    wrapper_resize(
+      wrap, xev->xconfigurerequest.width, xev->xconfigurerequest.height);
+    return GDK_FILTER_REMOVE;
+  }
+
+  if (suil_x11_child_update(&wrap->child, xev)) {
+    if (wrap->child.valid) {
+      init_hints(wrap, xev->xany.display, wrap->child.child);
+    }
+
+    gtk_widget_queue_resize(GTK_WIDGET(wrap));
+  }
+
+  return GDK_FILTER_CONTINUE;
+}
+
+/// Update the cached state of UI windows and ancestors from their events
+static GdkFilterReturn
+on_window_event(GdkXEvent* xevent, GdkEvent* event, gpointer data)
+{
+  (void)event;
+  (void)data;
+
+  const XEvent* const xev = (const XEvent*)xevent;
+
+  if (xev->type == PropertyNotify) {
+    SuilX11Wrapper* const wrap = (SuilX11Wrapper*)g_hash_table_lookup(
+      hint_windows, GSIZE_TO_POINTER(xev->xproperty.window));
+
+    if (wrap && suil_x11_hints_update(&wrap->hints, xev)) {
+      wrap->size_hints_dirty = TRUE;
+      gtk_widget_queue_resize(GTK_WIDGET(wrap));
+    }
+  } else if (xev->type == ReparentNotify) {
+    // Reparenting is rare, and an ancestor may be shared by several UIs
+    for (GSList* w = wrappers; w; w = w->next) {
+      SuilX11Wrapper* const wrap = (SuilX11Wrapper*)w->data;
+
+      // Move the drag and drop proxy to the new ancestors
+      if (suil_x11_ancestors_invalidate(&wrap->ancestors, xev) && wrap->plug &&
+          gtk_widget_get_realized(GTK_WIDGET(wrap))) {
+        set_xdnd_proxy(wrap);
+      }
+    }
+  }
+
+  return GDK_FILTER_CONTINUE;
+}
+
+/// Start watching the events of the plug window, UI window, and ancestors
+static void
+watch_windows(SuilX11Wrapper* const wrap, GdkWindow* const plug_window)
+{
+  // Track the UI window as it is created, reparented, and destroyed
+  wrap->plug_window = (GdkWindow*)g_object_ref(plug_window);
+  gdk_window_set_events(plug_window,
+                        gdk_window_get_events(plug_window) |
+                          GDK_SUBSTRUCTURE_MASK);
+  gdk_window_add_filter(plug_window, on_plug_event, wrap);
+
+  // Share one filter for changes to UI windows and ancestors between wrappers
+  if (!wrappers) {
+    hint_windows = g_hash_table_new(NULL, NULL);
+    gdk_window_add_filter(NULL, on_window_event, NULL);
+  }
+
+  wrappers = g_slist_prepend(wrappers, wrap);
+}
+
+/// Stop watching window events, if the wrapper is still watching them
+static void
+unwatch_windows(SuilX11Wrapper* const wrap)
+{
+  GSList* const link = g_slist_find(wrappers, wrap);
+  if (!link) {
+    return;
+  }
+
+  gdk_window_remove_filter(wrap->plug_window, on_plug_event, wrap);
+  g_object_unref(wrap->plug_window);
+  wrap->plug_window = NULL;
+
+  wrappers = g_slist_delete_link(wrappers, link);
+  if (wrap->hints.window) {
+    g_hash_table_remove(hint_windows, GSIZE_TO_POINTER(wrap->hints.window));
+  }
+
+  if (!wrappers) {
+    gdk_window_remove_filter(NULL, on_window_event, NULL);
+    g_hash_table_destroy(hint_windows);
+    hint_windows = NULL;
+  }
+}
+
 static void
 suil_x11_wrapper_finalize(GObject* gobject)
 {
   SuilX11Wrapper* const self = SUIL_X11_WRAPPER(gobject);
 
+  suil_scheduler_remove(&self->frame);
+  cancel_resize(self);
   self->wrapper->impl = NULL;
 
+  unwatch_windows(self);
+  suil_x11_ancestors_free(&self->ancestors);
+
   G_OBJECT_CLASS(suil_x11_wrapper_parent_class)->finalize(gobject);
 }
 
@@ -114,24 +333,11 @@ suil_x11_wrapper_realize(GtkWidget* w)
   GdkWindow* gwindow  = gtk_widget_get_window(GTK_WIDGET(wrap->plug));
   Display*   xdisplay = GDK_WINDOW_XDISPLAY(gwindow);
   Window     xwindow  = GDK_WINDOW_XID(gwindow);
-  XSelectInput(xdisplay, xwindow, SubstructureRedirectMask);
+  XSelectInput(
+    xdisplay, xwindow, SubstructureRedirectMask | SubstructureNotifyMask);
 
   // Setup drag/drop proxy from parent/grandparent window
-  Atom   xdnd_proxy_atom = gdk_x11_get_xatom_by_name("XdndProxy");
-  Window ui_window       = (Window)wrap->instance->ui_widget;
-
-  while (xwindow) {
-    XChangeProperty(xdisplay,
-                    xwindow,
-                    xdnd_proxy_atom,
-                    XA_WINDOW,
-                    32,
-                    PropModeReplace,
-                    (unsigned char*)&ui_window,
-                    1);
-
-    xwindow = suil_x11_get_parent(xdisplay, xwindow);
-  }
+  set_xdnd_proxy(wrap);
 }
 
 static void
@@ -146,6 +352,115 @@ suil_x11_wrapper_show(GtkWidget* w)
   gtk_widget_show(GTK_WIDGET(wrap->plug));
 }
 
+static void
+suil_x11_wrapper_idle(void* data)
+{
+  SuilX11Wrapper* const wrap = SUIL_X11_WRAPPER(data);
+
+  SUIL_TRACE_BEGIN(wrap->instance->trace, "idle");
+  suil_instance_flush(wrap->instance);
+  if (wrap->idle_iface) {
+    wrap->idle_iface->idle(wrap->instance->handle);
+  }
+  SUIL_TRACE_END(wrap->instance->trace, "idle");
+}
+
+/// Idle from the scheduler while unmapped, since ticks stop until it is mapped
+static void
+update_idle_source(SuilX11Wrapper* const wrap)
+{
+  if (!wrap->tick_id) {
+    return;
+  }
+
+  if (gtk_widget_get_mapped(GTK_WIDGET(wrap))) {
+    suil_scheduler_remove(&wrap->frame);
+  } else if (!wrap->frame.scheduler) {
+    suil_scheduler_add(wrap->instance->scheduler,
+                       &wrap->frame,
+                       wrap->instance->controller,
+                       suil_x11_wrapper_idle,
+                       wrap,
+                       wrap->update_rate,
+                       suil_glib_start_timer,
+                       suil_glib_stop_timer);
+  }
+}
+
+/// Slow down the UI while it can't be seen, and restore it once it can
+static void
+update_visibility(SuilX11Wrapper* const wrap)
+{
+  const GdkWindowState hidden_states =
+    GDK_WINDOW_STATE_WITHDRAWN | GDK_WINDOW_STATE_ICONIFIED;
+
+  suil_scheduler_set_visible(&wrap->frame,
+                             gtk_widget_get_mapped(GTK_WIDGET(wrap)) &&
+                               !(wrap->toplevel_state & hidden_states) &&
+                               !wrap->obscured);
+}
+
+static gboolean
+on_toplevel_state_event(GtkWidget*           widget,
+                        GdkEventWindowState* event,
+                        gpointer             data)
+{
+  SuilX11Wrapper* const wrap = SUIL_X11_WRAPPER(data);
+
+  if (widget == wrap->toplevel) {
+    wrap->toplevel_state = event->new_window_state;
+    update_visibility(wrap);
+  }
+
+  return FALSE;
+}
+
+static void
+suil_x11_wrapper_map(GtkWidget* w)
+{
+  SuilX11Wrapper* const wrap = SUIL_X11_WRAPPER(w);
+
+  GTK_WIDGET_CLASS(suil_x11_wrapper_parent_class)->map(w);
+
+  // Track the state of the toplevel, which is iconified or withdrawn by the WM
+  GtkWidget* const toplevel = gtk_widget_get_toplevel(w);
+  if (toplevel != wrap->toplevel && gtk_widget_is_toplevel(toplevel)) {
+    GdkWindow* const window = gtk_widget_get_window(toplevel);
+
+    wrap->toplevel       = toplevel;
+    wrap->toplevel_state = window ? gdk_window_get_state(window) : 0;
+    g_signal_connect_object(toplevel,
+                            "window-state-event",
+                            G_CALLBACK(on_toplevel_state_event),
+                            wrap,
+                            (GConnectFlags)0);
+  }
+
+  update_idle_source(wrap);
+  update_visibility(wrap);
+}
+
+static void
+suil_x11_wrapper_unmap(GtkWidget* w)
+{
+  SuilX11Wrapper* const wrap = SUIL_X11_WRAPPER(w);
+
+  GTK_WIDGET_CLASS(suil_x11_wrapper_parent_class)->unmap(w);
+
+  update_idle_source(wrap);
+  update_visibility(wrap);
+}
+
+static gboolean
+suil_x11_wrapper_visibility_event(GtkWidget* w, GdkEventVisibility* event)
+{
+  SuilX11Wrapper* const wrap = SUIL_X11_WRAPPER(w);
+
+  wrap->obscured = event->state == GDK_VISIBILITY_FULLY_OBSCURED;
+  update_visibility(wrap);
+  return FALSE;
+}
+
 static gboolean
 forward_key_event(SuilX11Wrapper* socket, GdkEvent* gdk_event)
 {
@@ -205,13 +520,10 @@ update_wm_hints(SuilX11Wrapper* wrap, gboolean force)
     return;
   }
 
-  // Fetch hints from X
-  GdkWindow* window   = gtk_widget_get_window(GTK_WIDGET(wrap->plug));
-  long       supplied = 0;
-  XGetWMNormalHints(GDK_WINDOW_XDISPLAY(window),
-                    (Window)wrap->instance->ui_widget,
-                    &wrap->size_hints,
-                    &supplied);
+  // Get hints from X, which are only read again after they change
+  GdkWindow* window = gtk_widget_get_window(GTK_WIDGET(wrap->plug));
+  wrap->size_hints =
+    *suil_x11_hints_get(&wrap->hints, GDK_WINDOW_XDISPLAY(window));
 
   // Preserve old "custom" size if necessary
   if ((old_hints.flags & USSize) && old_hints.x && old_hints.y) {
@@ -226,43 +538,30 @@ update_wm_hints(SuilX11Wrapper* wrap, gboolean force)
 static void
 forward_size_request(SuilX11Wrapper* socket, GtkAllocation* allocation)
 {
-  GdkWindow* gwindow   = gtk_widget_get_window(GTK_WIDGET(socket->plug));
-  Display*   xdisplay  = GDK_WINDOW_XDISPLAY(gwindow);
-  Window     ui_window = (Window)socket->instance->ui_widget;
+  GdkWindow* gwindow  = gtk_widget_get_window(GTK_WIDGET(socket->plug));
+  Display*   xdisplay = GDK_WINDOW_XDISPLAY(gwindow);
 
-  if (suil_x11_is_valid_child(xdisplay, GDK_WINDOW_XID(gwindow), ui_window)) {
+  if (socket->child.valid) {
     // Calculate allocation size constrained to X11 limits for widget
-    int        width  = allocation->width;
-    int        height = allocation->height;
-    XSizeHints hints;
-    memset(&hints, 0, sizeof(hints));
-    XGetNormalHints(xdisplay, ui_window, &hints);
-    if (hints.flags & PMaxSize) {
-      width  = MIN(width, hints.max_width);
-      height = MIN(height, hints.max_height);
+    const XSizeHints* hints  = suil_x11_hints_get(&socket->hints, xdisplay);
+    int               width  = allocation->width;
+    int               height = allocation->height;
+    if (hints->flags & PMaxSize) {
+      width  = MIN(width, hints->max_width);
+      height = MIN(height, hints->max_height);
     }
-    if (hints.flags & PMinSize) {
-      width  = MAX(width, hints.min_width);
-      height = MAX(height, hints.min_height);
+    if (hints->flags & PMinSize) {
+      width  = MAX(width, hints->min_width);
+      height = MAX(height, hints->min_height);
     }
 
-    // Resize widget window
-    XResizeWindow(xdisplay, ui_window, (unsigned)width, (unsigned)height);
-
-    // Get actual widget geometry
-    Window       root    = 0;
-    int          wx      = 0;
-    int          wy      = 0;
-    unsigned int ww      = 0;
-    unsigned int wh      = 0;
-    unsigned int ignored = 0;
-    XGetGeometry(
-      xdisplay, ui_window, &root, &wx, &wy, &ww, &wh, &ignored, &ignored);
-
-    // Center widget in allocation
-    wx = (allocation->width - (int)ww) / 2;
-    wy = (allocation->height - (int)wh) / 2;
-    XMoveWindow(xdisplay, ui_window, wx, wy);
+    // Resize widget window and center it in allocation with one request
+    suil_x11_child_configure(&socket->child,
+                             xdisplay,
+                             (allocation->width - width) / 2,
+                             (allocation->height - height) / 2,
+                             width,
+                             height);
   } else {
     /* Child has not been realized, so unable to resize now.
        Queue an idle resize. */
@@ -287,12 +586,9 @@ suil_x11_wrapper_get_preferred_width(GtkWidget* widget,
                                      gint*      minimum_width,
                                      gint*      natural_width)
 {
-  SuilX11Wrapper* const self    = SUIL_X11_WRAPPER(widget);
-  GdkWindow* const      gwindow = gtk_widget_get_window(GTK_WIDGET(self->plug));
-  Display* const        xdisplay  = GDK_WINDOW_XDISPLAY(gwindow);
-  Window                ui_window = (Window)self->instance->ui_widget;
+  SuilX11Wrapper* const self = SUIL_X11_WRAPPER(widget);
 
-  if (suil_x11_is_valid_child(xdisplay, GDK_WINDOW_XID(gwindow), ui_window)) {
+  if (self->child.valid) {
     update_wm_hints(self, FALSE);
 
     if (self->size_hints.flags & USSize) {
@@ -303,9 +599,7 @@ suil_x11_wrapper_get_preferred_width(GtkWidget* widget,
       *natural_width = self->size_hints.min_width;
     } else {
       g_warning("UI size hints have no base or minimum size");
-      XWindowAttributes attrs;
-      XGetWindowAttributes(xdisplay, ui_window, &attrs);
-      *natural_width = attrs.width;
+      *natural_width = self->child.width;
     }
 
     *minimum_width = (self->size_hints.flags & PMinSize)
@@ -319,12 +613,9 @@ suil_x11_wrapper_get_preferred_height(GtkWidget* widget,
                                       gint*      minimum_height,
                                       gint*      natural_height)
 {
-  SuilX11Wrapper* const self    = SUIL_X11_WRAPPER(widget);
-  GdkWindow* const      gwindow = gtk_widget_get_window(GTK_WIDGET(self->plug));
-  Display*              xdisplay  = GDK_WINDOW_XDISPLAY(gwindow);
-  Window                ui_window = (Window)self->instance->ui_widget;
+  SuilX11Wrapper* const self = SUIL_X11_WRAPPER(widget);
 
-  if (suil_x11_is_valid_child(xdisplay, GDK_WINDOW_XID(gwindow), ui_window)) {
+  if (self->child.valid) {
     update_wm_hints(self, FALSE);
 
     if (self->size_hints.flags & USSize) {
@@ -335,9 +626,7 @@ suil_x11_wrapper_get_preferred_height(GtkWidget* widget,
       *natural_height = self->size_hints.min_height;
     } else {
       g_warning("UI size hints have no base or minimum size");
-      XWindowAttributes attrs;
-      XGetWindowAttributes(xdisplay, ui_window, &attrs);
-      *natural_height = attrs.height;
+      *natural_height = self->child.height;
     }
 
     *minimum_height = (self->size_hints.flags & PMinSize)
@@ -346,6 +635,30 @@ suil_x11_wrapper_get_preferred_height(GtkWidget* widget,
   }
 }
 
+/// Forward the latest allocation to the UI
+static void
+flush_resize(SuilX11Wrapper* const wrap)
+{
+  SUIL_TRACE_BEGIN(wrap->instance->trace, "resize");
+  forward_size_request(wrap, &wrap->resize_allocation);
+  SUIL_TRACE_END(wrap->instance->trace, "resize");
+
+  wrap->last_resize = suil_scheduler_now(wrap->instance->scheduler);
+}
+
+static gboolean
+on_resize_timeout(gpointer data)
+{
+  SuilX11Wrapper* const wrap = (SuilX11Wrapper*)data;
+
+  wrap->resize_id = 0;
+  if (wrap->plug && gtk_widget_get_mapped(GTK_WIDGET(wrap))) {
+    flush_resize(wrap);
+  }
+
+  return FALSE;
+}
+
 static void
 suil_x11_on_size_allocate(GtkWidget* widget, GtkAllocation* a)
 {
@@ -353,7 +666,18 @@ suil_x11_on_size_allocate(GtkWidget* widget, GtkAllocation* a)
 
   if (self->plug && gtk_widget_get_realized(widget) &&
       gtk_widget_get_mapped(widget) && gtk_widget_get_visible(widget)) {
-    forward_size_request(self, a);
+    // Forward at most one resize per frame, the latest when the timeout fires
+    self->resize_allocation = *a;
+    if (!self->resize_id) {
+      const uint32_t delay =
+        suil_scheduler_delay(self->instance->scheduler, self->last_resize);
+
+      if (delay) {
+        self->resize_id = g_timeout_add(delay, on_resize_timeout, self);
+      } else {
+        flush_resize(self);
+      }
+    }
   }
 }
 
@@ -363,13 +687,16 @@ suil_x11_wrapper_class_init(SuilX11WrapperClass* klass)
   GObjectClass* const   gobject_class = G_OBJECT_CLASS(klass);
   GtkWidgetClass* const widget_class  = GTK_WIDGET_CLASS(klass);
 
-  gobject_class->finalize            = suil_x11_wrapper_finalize;
-  widget_class->realize              = suil_x11_wrapper_realize;
-  widget_class->show                 = suil_x11_wrapper_show;
-  widget_class->key_press_event      = suil_x11_wrapper_key_event;
-  widget_class->key_release_event    = suil_x11_wrapper_key_event;
-  widget_class->get_preferred_width  = suil_x11_wrapper_get_preferred_width;
-  widget_class->get_preferred_height = suil_x11_wrapper_get_preferred_height;
+  gobject_class->finalize               = suil_x11_wrapper_finalize;
+  widget_class->realize                 = suil_x11_wrapper_realize;
+  widget_class->show                    = suil_x11_wrapper_show;
+  widget_class->map                     = suil_x11_wrapper_map;
+  widget_class->unmap                   = suil_x11_wrapper_unmap;
+  widget_class->visibility_notify_event = suil_x11_wrapper_visibility_event;
+  widget_class->key_press_event         = suil_x11_wrapper_key_event;
+  widget_class->key_release_event       = suil_x11_wrapper_key_event;
+  widget_class->get_preferred_width     = suil_x11_wrapper_get_preferred_width;
+  widget_class->get_preferred_height    = suil_x11_wrapper_get_preferred_height;
 }
 
 static void
@@ -379,52 +706,40 @@ suil_x11_wrapper_init(SuilX11Wrapper* self)
   self->wrapper          = NULL;
   self->instance         = NULL;
   self->idle_iface       = NULL;
-  self->idle_ms          = 1000 / 30; // 30 Hz default
+  self->update_rate      = SUIL_DEFAULT_UPDATE_RATE;
   self->size_hints_dirty = TRUE;
 
   memset(&self->size_hints, 0, sizeof(self->size_hints));
 }
 
-static int
-wrapper_resize(LV2UI_Feature_Handle handle, int width, int height)
+/// Idle the UI from the frame clock, at most at its update rate
+static gboolean
+on_tick(GtkWidget* widget, GdkFrameClock* clock, gpointer data)
 {
-  SuilX11Wrapper* const wrap = SUIL_X11_WRAPPER(handle);
+  (void)widget;
 
-  wrap->size_hints.width  = width;
-  wrap->size_hints.height = height;
-  if (width > 0 && height > 0) {
-    wrap->size_hints.flags |= USSize;
-  }
+  SuilX11Wrapper* const wrap = SUIL_X11_WRAPPER(data);
 
-  // Fetch hints to get size constraints (probably) updated by plugin
-  wrap->size_hints_dirty = TRUE;
+  const float throttled =
+    wrap->update_rate / (float)wrap->frame.stats.throttle;
 
-  gtk_widget_queue_resize(GTK_WIDGET(handle));
-  return 0;
-}
+  const float rate = (wrap->frame.hidden && throttled > SUIL_HIDDEN_UPDATE_RATE)
+                       ? SUIL_HIDDEN_UPDATE_RATE
+                       : throttled;
 
-static gboolean
-suil_x11_wrapper_idle(void* data)
-{
-  SuilX11Wrapper* const wrap = SUIL_X11_WRAPPER(data);
+  const gint64 period  = rate > 0.0f ? (gint64)(1000000.0f / rate) : 0;
+  const gint64 now     = gdk_frame_clock_get_frame_time(clock);
+  gint64       refresh = 0;
+  gdk_frame_clock_get_refresh_info(clock, now, &refresh, NULL);
 
-  wrap->idle_iface->idle(wrap->instance->handle);
-
-  GdkWindow* const gwindow = gtk_widget_get_window(GTK_WIDGET(wrap->plug));
-  const Window     window  = GDK_WINDOW_XID(gwindow);
-  Display* const   display = GDK_WINDOW_XDISPLAY(gwindow);
-  XEvent           event   = {0};
-  while (XCheckWindowEvent(display, window, SubstructureRedirectMask, &event)) {
-    if (event.type == MapRequest) {
-      XMapWindow(display, event.xmaprequest.window);
-    } else if (event.type == ConfigureRequest) {
-      wrap->size_hints.flags = 0;
-      wrap->size_hints_dirty = TRUE;
-      wrapper_resize(wrap, event.xconfigure.width, event.xconfigure.height);
-    }
+  // Run if a period has passed, give or take half a frame of jitter
+  if (wrap->frame.due || now - wrap->last_tick >= period - (refresh / 2)) {
+    wrap->frame.due = false;
+    wrap->last_tick = now;
+    suil_scheduler_call(wrap->instance->scheduler, &wrap->frame);
   }
 
-  return TRUE; // Continue calling
+  return G_SOURCE_CONTINUE;
 }
 
 static int
@@ -442,16 +757,17 @@ wrapper_wrap(SuilWrapper* wrapper, SuilInstance* instance)
   Window      ui_window = (Window)instance->ui_widget;
 
   gdk_display_sync(display);
-  if (suil_x11_is_valid_child(xdisplay, GDK_WINDOW_XID(gwindow), ui_window)) {
-    XWindowAttributes attrs;
-    XGetWindowAttributes(xdisplay, ui_window, &attrs);
+  suil_x11_child_init(
+    &wrap->child, xdisplay, GDK_WINDOW_XID(gwindow), ui_window);
+  if (wrap->child.valid) {
+    init_hints(wrap, xdisplay, ui_window);
 
     update_wm_hints(wrap, TRUE);
     if (!(wrap->size_hints.flags & PBaseSize)) {
       // Fall back to using initial size as base size
       wrap->size_hints.flags |= PBaseSize;
-      wrap->size_hints.base_width  = attrs.width;
-      wrap->size_hints.base_height = attrs.height;
+      wrap->size_hints.base_width  = wrap->child.width;
+      wrap->size_hints.base_height = wrap->child.height;
     }
   }
 
@@ -462,9 +778,27 @@ wrapper_wrap(SuilWrapper* wrapper, SuilInstance* instance)
         LV2_UI__idleInterface);
   }
 
-  if (idle_iface) {
-    wrap->idle_iface = idle_iface;
-    wrap->idle_id = g_timeout_add(wrap->idle_ms, suil_x11_wrapper_idle, wrap);
+  wrap->idle_iface = idle_iface;
+  if (idle_iface || suil_instance_needs_flush(instance)) {
+    if (wrap->frame_clock_idle) {
+      // Registered with the scheduler only while unmapped, but timed by it
+      wrap->frame.func           = suil_x11_wrapper_idle;
+      wrap->frame.data           = wrap;
+      wrap->frame.owner          = instance->controller;
+      wrap->frame.stats.throttle = 1U;
+      wrap->tick_id =
+        gtk_widget_add_tick_callback(GTK_WIDGET(wrap), on_tick, wrap, NULL);
+      update_idle_source(wrap);
+    } else {
+      suil_scheduler_add(instance->scheduler,
+                         &wrap->frame,
+                         instance->controller,
+                         suil_x11_wrapper_idle,
+                         wrap,
+                         wrap->update_rate,
+                         suil_glib_start_timer,
+                         suil_glib_stop_timer);
+    }
   }
 
   g_signal_connect(
@@ -483,19 +817,27 @@ wrapper_free(SuilWrapper* wrapper)
 {
   if (wrapper->impl) {
     SuilX11Wrapper* const wrap = SUIL_X11_WRAPPER(wrapper->impl);
+
+    // Stop idling and resizing now, the widget may outlive the instance
+    if (wrap->tick_id) {
+      gtk_widget_remove_tick_callback(GTK_WIDGET(wrap), wrap->tick_id);
+      wrap->tick_id = 0;
+    }
+
+    suil_scheduler_remove(&wrap->frame);
+    cancel_resize(wrap);
+    unwatch_windows(wrap);
     gtk_widget_destroy(GTK_WIDGET(wrap));
   }
 }
 
 SUIL_LIB_EXPORT
 SuilWrapper*
-suil_wrapper_new(SuilHost*      host,
-                 const char*    host_type_uri,
-                 const char*    ui_type_uri,
-                 LV2_Feature*** features,
-                 unsigned       n_features)
+suil_wrapper_new(SuilHost*     host,
+                 const char*   host_type_uri,
+                 const char*   ui_type_uri,
+                 SuilFeatures* features)
 {
-  (void)host;
   (void)host_type_uri;
   (void)ui_type_uri;
 
@@ -509,36 +851,22 @@ suil_wrapper_new(SuilHost*      host,
   wrapper->impl             = wrap;
   wrapper->resize.handle    = wrap;
   wrapper->resize.ui_resize = wrapper_resize;
+  wrap->frame_clock_idle    = host->frame_clock_idle;
 
   gtk_widget_set_sensitive(GTK_WIDGET(wrap), TRUE);
   gtk_widget_set_can_focus(GTK_WIDGET(wrap), TRUE);
+  gtk_widget_add_events(GTK_WIDGET(wrap), GDK_VISIBILITY_NOTIFY_MASK);
 
   const intptr_t parent_id = (intptr_t)gtk_plug_get_id(wrap->plug);
-  suil_add_feature(features, &n_features, LV2_UI__parent, (void*)parent_id);
-  suil_add_feature(features, &n_features, LV2_UI__resize, &wrapper->resize);
-  suil_add_feature(features, &n_features, LV2_UI__idleInterface, NULL);
-
-  // Scan for URID map and options
-  LV2_URID_Map*       map     = NULL;
-  LV2_Options_Option* options = NULL;
-  for (LV2_Feature** f = *features; *f && (!map || !options); ++f) {
-    if (!strcmp((*f)->URI, LV2_OPTIONS__options)) {
-      options = (LV2_Options_Option*)(*f)->data;
-    } else if (!strcmp((*f)->URI, LV2_URID__map)) {
-      map = (LV2_URID_Map*)(*f)->data;
-    }
-  }
 
-  if (map && options) {
-    // Set UI update rate if given
-    LV2_URID ui_updateRate = map->map(map->handle, LV2_UI__updateRate);
-    for (LV2_Options_Option* o = options; o->key; ++o) {
-      if (o->key == ui_updateRate) {
-        wrap->idle_ms = (guint)(1000.0f / *(const float*)o->value);
-        break;
-      }
-    }
-  }
+  watch_windows(wrap, gtk_widget_get_window(GTK_WIDGET(wrap->plug)));
+
+  suil_add_feature(features, LV2_UI__parent, (void*)parent_id);
+  suil_add_feature(features, LV2_UI__resize, &wrapper->resize);
+  suil_add_feature(features, LV2_UI__idleInterface, NULL);
+
+  // Set UI update rate if given
+  wrap->update_rate = suil_get_update_rate(features);
 
   return wrapper;
 }
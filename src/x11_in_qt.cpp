@@ -2,6 +2,8 @@
 // Copyright 2015 Rui Nuno Capela <rncbc@rncbc.org>
 // SPDX-License-Identifier: ISC
 
+#include "qt_timer.h"
+#include "scheduler.h"
 #include "suil_internal.h"
 #include "warnings.h"
 
@@ -10,9 +12,13 @@
 #include <suil/suil.h>
 
 SUIL_DISABLE_QT_WARNINGS
+#include <QEvent>
+#include <QHideEvent>
+#include <QPointer>
 #include <QResizeEvent>
+#include <QShowEvent>
 #include <QSize>
-#include <QTimerEvent>
+#include <QTimer>
 #include <QWidget>
 #include <Qt>
 #include <QtGlobal>
@@ -28,6 +34,7 @@ SUIL_RESTORE_WARNINGS
 
 // IWYU pragma: no_include <qguiapplication_platform.h>
 
+#include <cstdint>
 #include <cstdlib>
 
 #undef signals
@@ -64,13 +71,23 @@ public:
   {
     _instance   = instance;
     _idle_iface = idle_iface;
-    if (_idle_iface && _ui_timer == 0) {
-      _ui_timer = this->startTimer(30, Qt::CoarseTimer);
+    if ((_idle_iface || suil_instance_needs_flush(instance)) &&
+        !_frame.scheduler) {
+      suil_scheduler_add(instance->scheduler,
+                         &_frame,
+                         instance->controller,
+                         on_frame,
+                         this,
+                         _update_rate,
+                         suil_qt_start_timer,
+                         suil_qt_stop_timer);
     }
   }
 
   void set_window(Window window) { _window = window; }
 
+  void set_update_rate(float update_rate) { _update_rate = update_rate; }
+
   QSize sizeHint() const override
   {
     if (_window) {
@@ -102,40 +119,125 @@ protected:
     QWidget::resizeEvent(event);
 
     if (_window) {
-      XResizeWindow(getX11Display(),
-                    _window,
-                    static_cast<unsigned>(event->size().width()),
-                    static_cast<unsigned>(event->size().height()));
+      // Forward at most one resize per frame, the latest when the timer fires
+      _resize_size = event->size();
+      if (!_resize_pending) {
+        const uint32_t delay =
+          _instance ? suil_scheduler_delay(_instance->scheduler, _last_resize)
+                    : 0U;
+
+        if (delay) {
+          _resize_pending = true;
+          QTimer::singleShot(
+            static_cast<int>(delay), Qt::PreciseTimer, this, [this]() {
+              _resize_pending = false;
+              flush_resize();
+            });
+        } else {
+          flush_resize();
+        }
+      }
     }
   }
 
-  void timerEvent(QTimerEvent* event) override
+  void showEvent(QShowEvent* event) override
+  {
+    QWidget::showEvent(event);
+    watch_window();
+    _shown = true;
+    update_visibility();
+  }
+
+  void hideEvent(QHideEvent* event) override
   {
-    if (event->timerId() == _ui_timer && _idle_iface) {
-      _idle_iface->idle(_instance->handle);
+    QWidget::hideEvent(event);
+    _shown = false; // Also sent when minimized or moved to another desktop
+    update_visibility();
+  }
+
+  bool eventFilter(QObject* object, QEvent* event) override
+  {
+    if (object == _window_widget &&
+        event->type() == QEvent::WindowStateChange) {
+      update_visibility();
     }
 
-    QWidget::timerEvent(event);
+    return QWidget::eventFilter(object, event);
   }
 
   void closeEvent(QCloseEvent* event) override
   {
-    if (_ui_timer && _idle_iface) {
-      this->killTimer(_ui_timer);
-      _ui_timer = 0;
-    }
+    suil_scheduler_remove(&_frame);
 
     QWidget::closeEvent(event);
   }
 
 private:
+  /// Forward the latest size to the UI
+  void flush_resize()
+  {
+    SuilTrace* const trace = _instance ? _instance->trace : nullptr;
+
+    SUIL_TRACE_BEGIN(trace, "resize");
+    XResizeWindow(getX11Display(),
+                  _window,
+                  static_cast<unsigned>(_resize_size.width()),
+                  static_cast<unsigned>(_resize_size.height()));
+    SUIL_TRACE_END(trace, "resize");
+
+    if (_instance) {
+      _last_resize = suil_scheduler_now(_instance->scheduler);
+    }
+  }
+
+  /// Watch the window's state, which is only sent to the top-level widget
+  void watch_window()
+  {
+    QWidget* const window_widget = window();
+    if (window_widget != _window_widget) {
+      if (_window_widget) {
+        _window_widget->removeEventFilter(this);
+      }
+
+      _window_widget = window_widget;
+      _window_widget->installEventFilter(this);
+    }
+  }
+
+  /// Slow down the UI while it can't be seen, and restore it once it can
+  void update_visibility()
+  {
+    suil_scheduler_set_visible(&_frame, _shown && !window()->isMinimized());
+  }
+
+  static void on_frame(void* data)
+  {
+    auto* const self = static_cast<SuilQX11Widget*>(data);
+
+    SUIL_TRACE_BEGIN(self->_instance->trace, "idle");
+    suil_instance_flush(self->_instance);
+    if (self->_idle_iface) {
+      self->_idle_iface->idle(self->_instance->handle);
+    }
+    SUIL_TRACE_END(self->_instance->trace, "idle");
+  }
+
   SuilInstance*               _instance{};
   const LV2UI_Idle_Interface* _idle_iface{};
   Window                      _window{};
-  int                         _ui_timer{};
+  SuilFrameEntry              _frame{};
+  float                       _update_rate{SUIL_DEFAULT_UPDATE_RATE};
+  QSize                       _resize_size;
+  uint64_t                    _last_resize{};
+  bool                        _resize_pending{};
+  QPointer<QWidget>           _window_widget;
+  bool                        _shown{};
 };
 
-SuilQX11Widget::~SuilQX11Widget() = default;
+SuilQX11Widget::~SuilQX11Widget()
+{
+  suil_scheduler_remove(&_frame);
+}
 
 struct SuilX11InQt5Wrapper {
   QWidget*        host_widget;
@@ -182,13 +284,14 @@ wrapper_wrap(SuilWrapper* wrapper, SuilInstance* instance)
     impl->parent->setMaximumSize(hints.max_width, hints.max_height);
   }
 
+  const LV2UI_Idle_Interface* idle_iface = nullptr;
   if (instance->descriptor->extension_data) {
-    const auto* idle_iface = static_cast<const LV2UI_Idle_Interface*>(
+    idle_iface = static_cast<const LV2UI_Idle_Interface*>(
       instance->descriptor->extension_data(LV2_UI__idleInterface));
-
-    ew->start_idle(instance, idle_iface);
   }
 
+  ew->start_idle(instance, idle_iface);
+
   impl->host_widget     = ew;
   instance->host_widget = impl->host_widget;
 
@@ -209,11 +312,7 @@ extern "C" {
 
 SUIL_LIB_EXPORT
 SuilWrapper*
-suil_wrapper_new(SuilHost*,
-                 const char*,
-                 const char*,
-                 LV2_Feature*** features,
-                 unsigned       n_features)
+suil_wrapper_new(SuilHost*, const char*, const char*, SuilFeatures* features)
 {
   auto* const impl =
     static_cast<SuilX11InQt5Wrapper*>(calloc(1, sizeof(SuilX11InQt5Wrapper)));
@@ -231,9 +330,12 @@ suil_wrapper_new(SuilHost*,
   wrapper->resize.ui_resize = wrapper_resize;
 
   void* parent_id = reinterpret_cast<void*>(ew->winId());
-  suil_add_feature(features, &n_features, LV2_UI__parent, parent_id);
-  suil_add_feature(features, &n_features, LV2_UI__resize, &wrapper->resize);
-  suil_add_feature(features, &n_features, LV2_UI__idleInterface, nullptr);
+  suil_add_feature(features, LV2_UI__parent, parent_id);
+  suil_add_feature(features, LV2_UI__resize, &wrapper->resize);
+  suil_add_feature(features, LV2_UI__idleInterface, nullptr);
+
+  // Set UI update rate if given
+  ew->set_update_rate(suil_get_update_rate(features));
 
   return wrapper;
 }
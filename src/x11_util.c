@@ -4,9 +4,13 @@
 #include "x11_util.h"
 
 #include <X11/X.h>
+#include <X11/Xatom.h>
 #include <X11/Xlib.h>
+#include <X11/Xutil.h>
 
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 
 bool
 suil_x11_is_valid_child(Display* const display,
@@ -33,6 +37,210 @@ suil_x11_is_valid_child(Display* const display,
   return false;
 }
 
+void
+suil_x11_child_init(SuilX11Child* const tracker,
+                    Display* const      display,
+                    const Window        parent,
+                    const Window        child)
+{
+  tracker->parent = parent;
+  tracker->child  = child;
+  tracker->serial = 0U;
+  tracker->valid  = suil_x11_is_valid_child(display, parent, child);
+  if (tracker->valid) {
+    Window   root   = 0U;
+    unsigned width  = 0U;
+    unsigned height = 0U;
+    unsigned border = 0U;
+    unsigned depth  = 0U;
+    XGetGeometry(display,
+                 child,
+                 &root,
+                 &tracker->x,
+                 &tracker->y,
+                 &width,
+                 &height,
+                 &border,
+                 &depth);
+
+    tracker->width  = (int)width;
+    tracker->height = (int)height;
+  }
+}
+
+bool
+suil_x11_child_update(SuilX11Child* const tracker, const XEvent* const event)
+{
+  const bool was_valid = tracker->valid;
+
+  if (!tracker->child) {
+    return false;
+  }
+
+  if (event->type == CreateNotify) {
+    if (event->xcreatewindow.window == tracker->child) {
+      tracker->valid  = event->xcreatewindow.parent == tracker->parent;
+      tracker->x      = event->xcreatewindow.x;
+      tracker->y      = event->xcreatewindow.y;
+      tracker->width  = event->xcreatewindow.width;
+      tracker->height = event->xcreatewindow.height;
+    }
+  } else if (event->type == ReparentNotify) {
+    if (event->xreparent.window == tracker->child) {
+      tracker->valid = event->xreparent.parent == tracker->parent;
+      tracker->x     = event->xreparent.x;
+      tracker->y     = event->xreparent.y;
+    }
+  } else if (event->type == ConfigureNotify) {
+    // Ignore events from before our last request, which are already stale
+    if (event->xconfigure.window == tracker->child &&
+        (long)(event->xconfigure.serial - tracker->serial) >= 0) {
+      tracker->x      = event->xconfigure.x;
+      tracker->y      = event->xconfigure.y;
+      tracker->width  = event->xconfigure.width;
+      tracker->height = event->xconfigure.height;
+    }
+  } else if (event->type == DestroyNotify) {
+    if (event->xdestroywindow.window == tracker->child) {
+      tracker->valid = false;
+    }
+  }
+
+  return tracker->valid != was_valid;
+}
+
+void
+suil_x11_child_configure(SuilX11Child* const tracker,
+                         Display* const      display,
+                         const int           x,
+                         const int           y,
+                         const int           width,
+                         const int           height)
+{
+  XWindowChanges changes;
+  memset(&changes, 0, sizeof(changes));
+  changes.x      = x;
+  changes.y      = y;
+  changes.width  = width > 0 ? width : 1;
+  changes.height = height > 0 ? height : 1;
+
+  if (!tracker->valid ||
+      (changes.x == tracker->x && changes.y == tracker->y &&
+       changes.width == tracker->width && changes.height == tracker->height)) {
+    return;
+  }
+
+  tracker->serial = NextRequest(display);
+  XConfigureWindow(display,
+                   tracker->child,
+                   CWX | CWY | CWWidth | CWHeight,
+                   &changes);
+
+  // Assume the request succeeds, ConfigureNotify will correct it if not
+  tracker->x      = changes.x;
+  tracker->y      = changes.y;
+  tracker->width  = changes.width;
+  tracker->height = changes.height;
+}
+
+bool
+suil_x11_ancestors_update(SuilX11Ancestors* const chain,
+                          Display* const          display,
+                          const Window            window,
+                          const Window            parent)
+{
+  if (chain->valid && chain->count > 1U && chain->windows[0] == window &&
+      chain->windows[1] == parent) {
+    return false;
+  }
+
+  chain->count = 0U;
+  chain->valid = true;
+  for (Window w = window; w; w = suil_x11_get_parent(display, w)) {
+    Window* const windows =
+      (Window*)realloc(chain->windows, (chain->count + 1U) * sizeof(Window));
+
+    if (!windows) {
+      chain->valid = false;
+      break;
+    }
+
+    chain->windows                 = windows;
+    chain->windows[chain->count++] = w;
+  }
+
+  return true;
+}
+
+bool
+suil_x11_ancestors_invalidate(SuilX11Ancestors* const chain,
+                              const XEvent* const     event)
+{
+  if (event->type == ReparentNotify && chain->valid) {
+    for (unsigned i = 0U; i < chain->count; ++i) {
+      if (chain->windows[i] == event->xreparent.window) {
+        // Ignore events that the chain already reflects
+        if (i + 1U < chain->count &&
+            chain->windows[i + 1U] == event->xreparent.parent) {
+          return false;
+        }
+
+        chain->valid = false;
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+void
+suil_x11_ancestors_free(SuilX11Ancestors* const chain)
+{
+  free(chain->windows);
+  chain->windows = NULL;
+  chain->count   = 0U;
+  chain->valid   = false;
+}
+
+void
+suil_x11_hints_init(SuilX11Hints* const cache,
+                    Display* const      display,
+                    const Window        window)
+{
+  XSelectInput(display, window, PropertyChangeMask);
+  cache->window = window;
+  cache->dirty  = true;
+}
+
+const XSizeHints*
+suil_x11_hints_get(SuilX11Hints* const cache, Display* const display)
+{
+  if (cache->dirty) {
+    long supplied = 0;
+    if (!XGetWMNormalHints(display, cache->window, &cache->hints, &supplied)) {
+      memset(&cache->hints, 0, sizeof(cache->hints));
+    }
+
+    cache->dirty = false;
+  }
+
+  return &cache->hints;
+}
+
+bool
+suil_x11_hints_update(SuilX11Hints* const cache, const XEvent* const event)
+{
+  if (event->type == PropertyNotify && cache->window &&
+      event->xproperty.window == cache->window &&
+      event->xproperty.atom == XA_WM_NORMAL_HINTS) {
+    cache->dirty = true;
+    return true;
+  }
+
+  return false;
+}
+
 Window
 suil_x11_get_parent(Display* display, Window child)
 {
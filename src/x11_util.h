@@ -6,13 +6,109 @@
 
 #include <X11/X.h>
 #include <X11/Xlib.h>
+#include <X11/Xutil.h>
 
 #include <stdbool.h>
 
+/**
+   A UI window embedded in a parent window, and its geometry.
+
+   This is queried from the server once, then kept up to date from the
+   SubstructureNotify events of the parent, so checking it is free.
+*/
+typedef struct {
+  Window        parent; ///< Window that the UI is embedded in
+  Window        child;  ///< UI window
+  unsigned long serial; ///< Serial of the last configure request
+  int           x;      ///< Last known horizontal position in parent
+  int           y;      ///< Last known vertical position in parent
+  int           width;  ///< Last known width
+  int           height; ///< Last known height
+  bool          valid;  ///< True if `child` is currently a child of `parent`
+} SuilX11Child;
+
+/**
+   The WM_NORMAL_HINTS of a UI window.
+
+   The hints are read from the server only after a PropertyNotify event says
+   they have changed, so getting them is usually free.
+*/
+typedef struct {
+  Window     window; ///< Window the hints are read from
+  XSizeHints hints;  ///< Last hints read from the window
+  bool       dirty;  ///< True if the hints must be read again
+} SuilX11Hints;
+
+/**
+   A window and its ancestors, up to but not including the root window.
+
+   This is only queried from the server when it may be out of date, which is
+   when it is first used, when the window has been moved to another parent,
+   or after a ReparentNotify event for any window in it.
+*/
+typedef struct {
+  Window*  windows; ///< The window itself, then each of its ancestors
+  unsigned count;   ///< Number of windows
+  bool     valid;   ///< True if the chain is up to date
+} SuilX11Ancestors;
+
 /// Return whether `child` can be found in the subtree under `parent`
 bool
 suil_x11_is_valid_child(Display* display, Window parent, Window child);
 
+/// Start tracking whether `child` is a child of `parent` (one round trip)
+void
+suil_x11_child_init(SuilX11Child* tracker,
+                    Display*      display,
+                    Window        parent,
+                    Window        child);
+
+/// Update a tracked child from an event, return true if its validity changed
+bool
+suil_x11_child_update(SuilX11Child* tracker, const XEvent* event);
+
+/// Move and resize a valid tracked child if necessary, without a round trip
+void
+suil_x11_child_configure(SuilX11Child* tracker,
+                         Display*      display,
+                         int           x,
+                         int           y,
+                         int           width,
+                         int           height);
+
+/**
+   Query the ancestors of `window` if the cached chain may be out of date.
+
+   The `parent` is the expected parent of the window, used to detect that it
+   has been reparented without waiting for an event.  Returns true if the
+   chain was queried again.
+*/
+bool
+suil_x11_ancestors_update(SuilX11Ancestors* chain,
+                          Display*          display,
+                          Window            window,
+                          Window            parent);
+
+/// Invalidate the chain if an event moves one of its windows to a new parent
+bool
+suil_x11_ancestors_invalidate(SuilX11Ancestors* chain, const XEvent* event);
+
+/// Free the windows in a chain
+void
+suil_x11_ancestors_free(SuilX11Ancestors* chain);
+
+/// Start caching the hints of `window`, which are read on the next get
+void
+suil_x11_hints_init(SuilX11Hints* cache, Display* display, Window window);
+
+/// Return the cached hints of a window, reading them first if necessary
+const XSizeHints*
+suil_x11_hints_get(SuilX11Hints* cache, Display* display);
+
+/// Update cached hints from an event, return true if they have changed
+bool
+suil_x11_hints_update(SuilX11Hints* cache, const XEvent* event);
+
 /// Return the non-root parent window of `child` if it has one, or zero
 Window
 suil_x11_get_parent(Display* display, Window child);
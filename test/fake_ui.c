@@ -0,0 +1,92 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+// A fake UI library for testing without a toolkit
+
+#include <lv2/core/lv2.h>
+#include <lv2/ui/ui.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/// A UI that writes every port event it receives back to the plugin
+typedef struct {
+  LV2UI_Write_Function write;      ///< Function to write to the plugin
+  LV2UI_Controller     controller; ///< Controller passed to write
+} EchoUI;
+
+static LV2UI_Handle
+instantiate(const LV2UI_Descriptor*   descriptor,
+            const char*               plugin_uri,
+            const char*               bundle_path,
+            LV2UI_Write_Function      write_function,
+            LV2UI_Controller          controller,
+            LV2UI_Widget*             widget,
+            const LV2_Feature* const* features)
+{
+  (void)descriptor;
+  (void)plugin_uri;
+  (void)bundle_path;
+  (void)features;
+
+  EchoUI* const ui = (EchoUI*)calloc(1, sizeof(EchoUI));
+  if (ui) {
+    ui->write      = write_function;
+    ui->controller = controller;
+    *widget        = ui;
+  }
+
+  return ui;
+}
+
+static LV2UI_Handle
+instantiate_failure(const LV2UI_Descriptor*   descriptor,
+                    const char*               plugin_uri,
+                    const char*               bundle_path,
+                    LV2UI_Write_Function      write_function,
+                    LV2UI_Controller          controller,
+                    LV2UI_Widget*             widget,
+                    const LV2_Feature* const* features)
+{
+  (void)descriptor;
+  (void)plugin_uri;
+  (void)bundle_path;
+  (void)write_function;
+  (void)controller;
+  (void)widget;
+  (void)features;
+
+  return NULL;
+}
+
+static void
+cleanup(LV2UI_Handle handle)
+{
+  free(handle);
+}
+
+static void
+port_event(LV2UI_Handle handle,
+           uint32_t     port_index,
+           uint32_t     buffer_size,
+           uint32_t     format,
+           const void*  buffer)
+{
+  EchoUI* const ui = (EchoUI*)handle;
+
+  ui->write(ui->controller, port_index, buffer_size, format, buffer);
+}
+
+static const LV2UI_Descriptor descriptors[] = {
+  {"urn:suil:test:echo", instantiate, cleanup, port_event, NULL},
+  {"urn:suil:test:silent", instantiate, cleanup, NULL, NULL},
+  {"urn:suil:test:failure", instantiate_failure, cleanup, NULL, NULL},
+};
+
+LV2_SYMBOL_EXPORT const LV2UI_Descriptor*
+lv2ui_descriptor(const uint32_t index)
+{
+  return index < sizeof(descriptors) / sizeof(descriptors[0])
+           ? &descriptors[index]
+           : NULL;
+}
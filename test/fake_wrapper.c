@@ -0,0 +1,47 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+// A fake wrapper module for testing without a toolkit
+
+#include "suil_internal.h"
+
+#include <lv2/ui/ui.h>
+#include <suil/suil.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+static int
+wrapper_wrap(SuilWrapper* wrapper, SuilInstance* instance)
+{
+  // Use the wrapper itself as the widget, so tests can tell it was wrapped
+  instance->host_widget = wrapper;
+  return 0;
+}
+
+static void
+wrapper_free(SuilWrapper* wrapper)
+{
+  (void)wrapper;
+}
+
+SUIL_LIB_EXPORT
+SuilWrapper*
+suil_wrapper_new(SuilHost*     host,
+                 const char*   host_type_uri,
+                 const char*   ui_type_uri,
+                 SuilFeatures* features)
+{
+  (void)host;
+  (void)host_type_uri;
+  (void)ui_type_uri;
+
+  SuilWrapper* const wrapper = (SuilWrapper*)calloc(1, sizeof(SuilWrapper));
+  if (wrapper) {
+    wrapper->wrap = wrapper_wrap;
+    wrapper->free = wrapper_free;
+    suil_add_feature(features, LV2_UI__parent, (void*)(intptr_t)1);
+  }
+
+  return wrapper;
+}
@@ -0,0 +1,138 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#undef NDEBUG
+
+#include "thread.h"
+
+#include <lv2/ui/ui.h>
+#include <suil/suil.h>
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define N_REQUESTS 5U
+
+/// Requests that are ready to finish, in the order they became ready
+typedef struct {
+  SuilMutex            mutex;             ///< Lock for everything else
+  SuilCond             cond;              ///< Broadcast when ready
+  unsigned             n_ready;           ///< Number of ready requests
+  SuilInstanceRequest* ready[N_REQUESTS]; ///< Ready requests in order
+} Ready;
+
+static void
+write_func(SuilController controller,
+           uint32_t       port_index,
+           uint32_t       buffer_size,
+           uint32_t       protocol,
+           const void*    buffer)
+{
+  (void)controller;
+  (void)port_index;
+  (void)buffer_size;
+  (void)protocol;
+  (void)buffer;
+}
+
+static void
+on_ready(void* const data, SuilInstanceRequest* const request)
+{
+  Ready* const ready = (Ready*)data;
+
+  suil_mutex_lock(&ready->mutex);
+  assert(ready->n_ready < N_REQUESTS);
+  ready->ready[ready->n_ready++] = request;
+  suil_cond_broadcast(&ready->cond);
+  suil_mutex_unlock(&ready->mutex);
+}
+
+static SuilInstanceRequest*
+new_request(SuilHost* const   host,
+            Ready* const      ready,
+            const char* const ui_path,
+            const char* const ui_uri)
+{
+  return suil_instance_new_async(host,
+                                 NULL,
+                                 NULL,
+                                 "urn:suil:test:plugin",
+                                 ui_uri,
+                                 LV2_UI__X11UI,
+                                 "",
+                                 ui_path,
+                                 NULL,
+                                 on_ready,
+                                 ready);
+}
+
+static void
+test_async(const char* const ui_path)
+{
+  SuilHost* const host = suil_host_new(write_func, NULL, NULL, NULL);
+  assert(host);
+
+  Ready ready;
+  ready.n_ready = 0U;
+  assert(!suil_mutex_init(&ready.mutex));
+  assert(!suil_cond_init(&ready.cond));
+
+  // Start requests that succeed and fail in every way
+  SuilInstanceRequest* const requests[N_REQUESTS] = {
+    new_request(host, &ready, ui_path, "urn:suil:test:echo"),
+    new_request(host, &ready, ui_path, "urn:suil:test:missing"),
+    new_request(host, &ready, "/does/not/exist", "urn:suil:test:echo"),
+    new_request(host, &ready, ui_path, "urn:suil:test:failure"),
+    new_request(host, &ready, ui_path, "urn:suil:test:silent"),
+  };
+
+  // Every request becomes ready once, in the order they were made
+  suil_mutex_lock(&ready.mutex);
+  while (ready.n_ready < N_REQUESTS) {
+    suil_cond_wait(&ready.cond, &ready.mutex);
+  }
+  suil_mutex_unlock(&ready.mutex);
+
+  for (unsigned i = 0U; i < N_REQUESTS; ++i) {
+    assert(requests[i]);
+    assert(ready.ready[i] == requests[i]);
+  }
+
+  // Only the requests that could be loaded and instantiated make instances
+  SuilInstance* instances[N_REQUESTS] = {NULL, NULL, NULL, NULL, NULL};
+  for (unsigned i = 0U; i < N_REQUESTS; ++i) {
+    instances[i] = suil_instance_new_finish(requests[i]);
+    assert(!instances[i] == (i > 0U && i < 4U));
+  }
+
+  // The library was loaded once by the loader
+  const SuilCacheStats stats = suil_host_get_cache_stats(host);
+  assert(stats.library_misses == 1U);
+  assert(stats.library_hits == 3U);
+
+  suil_instance_free(instances[0]);
+  suil_instance_free(instances[4]);
+  suil_host_free(host);
+  suil_cond_destroy(&ready.cond);
+  suil_mutex_destroy(&ready.mutex);
+}
+
+static void
+test_free_unused_host(void)
+{
+  // Freeing a host that never loaded anything in the background is fine
+  SuilHost* const host = suil_host_new(write_func, NULL, NULL, NULL);
+  assert(host);
+  suil_host_free(host);
+}
+
+int
+main(int argc, char** argv)
+{
+  assert(argc == 2);
+
+  test_async(argv[1]);
+  test_free_unused_host();
+  return 0;
+}
@@ -0,0 +1,125 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#undef NDEBUG
+
+#include <lv2/ui/ui.h>
+#include <suil/suil.h>
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+static void
+write_func(SuilController controller,
+           uint32_t       port_index,
+           uint32_t       buffer_size,
+           uint32_t       protocol,
+           const void*    buffer)
+{
+  (void)controller;
+  (void)port_index;
+  (void)buffer_size;
+  (void)protocol;
+  (void)buffer;
+}
+
+static SuilInstance*
+new_instance(SuilHost* const   host,
+             const char* const ui_path,
+             const char* const ui_uri)
+{
+  return suil_instance_new(host,
+                           NULL,
+                           NULL,
+                           "urn:suil:test:plugin",
+                           ui_uri,
+                           LV2_UI__X11UI,
+                           "",
+                           ui_path,
+                           NULL);
+}
+
+static void
+test_cache(const char* const ui_path)
+{
+  SuilHost* const host = suil_host_new(write_func, NULL, NULL, NULL);
+  assert(host);
+
+  SuilCacheStats stats = suil_host_get_cache_stats(host);
+  assert(!stats.library_hits && !stats.library_misses);
+  assert(!stats.descriptor_hits && !stats.descriptor_misses);
+
+  // The first instance loads and indexes the library
+  SuilInstance* const a = new_instance(host, ui_path, "urn:suil:test:echo");
+  assert(a);
+  stats = suil_host_get_cache_stats(host);
+  assert(!stats.library_hits);
+  assert(stats.library_misses == 1U);
+  assert(!stats.descriptor_hits);
+  assert(stats.descriptor_misses == 1U);
+
+  // Later instances reuse the library and its index
+  SuilInstance* const b = new_instance(host, ui_path, "urn:suil:test:silent");
+  assert(b);
+  stats = suil_host_get_cache_stats(host);
+  assert(stats.library_hits == 1U);
+  assert(stats.library_misses == 1U);
+  assert(stats.descriptor_hits == 1U);
+  assert(stats.descriptor_misses == 1U);
+
+  // A UI that isn't in the library is a miss, even with an index
+  assert(!new_instance(host, ui_path, "urn:suil:test:missing"));
+  stats = suil_host_get_cache_stats(host);
+  assert(stats.library_hits == 2U);
+  assert(stats.descriptor_hits == 1U);
+  assert(stats.descriptor_misses == 2U);
+
+  // A library that fails to load isn't cached
+  assert(!new_instance(host, "/does/not/exist", "urn:suil:test:echo"));
+  stats = suil_host_get_cache_stats(host);
+  assert(stats.library_hits == 2U);
+  assert(stats.library_misses == 1U);
+
+  // The library is unloaded with the last instance that uses it
+  suil_instance_free(a);
+  suil_instance_free(b);
+
+  SuilInstance* const c = new_instance(host, ui_path, "urn:suil:test:echo");
+  assert(c);
+  stats = suil_host_get_cache_stats(host);
+  assert(stats.library_hits == 2U);
+  assert(stats.library_misses == 2U);
+  assert(stats.descriptor_misses == 3U);
+
+  suil_instance_free(c);
+  suil_host_free(host);
+}
+
+static void
+test_free_host_first(const char* const ui_path)
+{
+  SuilHost* const host = suil_host_new(write_func, NULL, NULL, NULL);
+  assert(host);
+
+  SuilInstance* const instance =
+    new_instance(host, ui_path, "urn:suil:test:echo");
+  assert(instance);
+
+  // Instances keep their library after the host and its cache are gone
+  suil_host_free(host);
+
+  const float value = 1.0f;
+  suil_instance_port_event(instance, 0U, sizeof(value), 0U, &value);
+  suil_instance_free(instance);
+}
+
+int
+main(int argc, char** argv)
+{
+  assert(argc == 2);
+
+  test_cache(argv[1]);
+  test_free_host_first(argv[1]);
+  return 0;
+}
@@ -0,0 +1,156 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#undef NDEBUG
+
+#include "suil_internal.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#define MAX_CHANGES 8U
+
+/// Controls passed to a flush function
+typedef struct {
+  uint32_t      n_changes;            ///< Number of controls received
+  uint32_t      indices[MAX_CHANGES]; ///< Index of each control
+  float         values[MAX_CHANGES];  ///< Value of each control
+  float         reset;                ///< Value to set port 1 to when flushed
+  SuilControls* controls;             ///< Controls to set while flushing
+} Changes;
+
+static void
+on_control(void* const data, const uint32_t index, const float value)
+{
+  Changes* const changes = (Changes*)data;
+
+  assert(changes->n_changes < MAX_CHANGES);
+  changes->indices[changes->n_changes] = index;
+  changes->values[changes->n_changes]  = value;
+  ++changes->n_changes;
+
+  if (changes->controls && index == 1U) {
+    assert(!suil_controls_set(changes->controls, index, changes->reset));
+  }
+}
+
+static void
+test_empty(void)
+{
+  SuilControls controls;
+  memset(&controls, 0, sizeof(controls));
+
+  Changes changes;
+  memset(&changes, 0, sizeof(changes));
+  suil_controls_flush(&controls, on_control, &changes);
+  assert(!changes.n_changes);
+
+  suil_controls_cleanup(&controls);
+}
+
+static void
+test_coalesce(void)
+{
+  SuilControls controls;
+  memset(&controls, 0, sizeof(controls));
+
+  // Only the latest value of each port is delivered, in index order
+  assert(!suil_controls_set(&controls, 7U, 1.0f));
+  assert(!suil_controls_set(&controls, 2U, 2.0f));
+  assert(!suil_controls_set(&controls, 7U, 3.0f));
+  assert(!suil_controls_set(&controls, 7U, 4.0f));
+  assert(controls.n_ports == 32U);
+
+  Changes changes;
+  memset(&changes, 0, sizeof(changes));
+  suil_controls_flush(&controls, on_control, &changes);
+  assert(changes.n_changes == 2U);
+  assert(changes.indices[0] == 2U);
+  assert(changes.values[0] == 2.0f);
+  assert(changes.indices[1] == 7U);
+  assert(changes.values[1] == 4.0f);
+
+  // Nothing is delivered again until it is set again
+  memset(&changes, 0, sizeof(changes));
+  suil_controls_flush(&controls, on_control, &changes);
+  assert(!changes.n_changes);
+
+  assert(!suil_controls_set(&controls, 2U, 5.0f));
+  suil_controls_flush(&controls, on_control, &changes);
+  assert(changes.n_changes == 1U);
+  assert(changes.indices[0] == 2U);
+  assert(changes.values[0] == 5.0f);
+
+  suil_controls_cleanup(&controls);
+  assert(!controls.values);
+  assert(!controls.dirty);
+  assert(!controls.n_ports);
+}
+
+static void
+test_grow(void)
+{
+  SuilControls controls;
+  memset(&controls, 0, sizeof(controls));
+
+  // Setting a high index grows the arrays and keeps earlier changes
+  assert(!suil_controls_set(&controls, 31U, 1.0f));
+  assert(!suil_controls_set(&controls, 32U, 2.0f));
+  assert(controls.n_ports == 64U);
+  assert(!suil_controls_set(&controls, 1000U, 3.0f));
+  assert(controls.n_ports == 1024U);
+
+  Changes changes;
+  memset(&changes, 0, sizeof(changes));
+  suil_controls_flush(&controls, on_control, &changes);
+  assert(changes.n_changes == 3U);
+  assert(changes.indices[0] == 31U);
+  assert(changes.values[0] == 1.0f);
+  assert(changes.indices[1] == 32U);
+  assert(changes.values[1] == 2.0f);
+  assert(changes.indices[2] == 1000U);
+  assert(changes.values[2] == 3.0f);
+
+  // Indices too large to fit are rejected
+  assert(suil_controls_set(&controls, UINT32_MAX, 4.0f));
+  assert(controls.n_ports == 1024U);
+
+  suil_controls_cleanup(&controls);
+}
+
+static void
+test_set_while_flushing(void)
+{
+  SuilControls controls;
+  memset(&controls, 0, sizeof(controls));
+
+  // A control set by the flush function is delivered by the next flush
+  Changes changes;
+  memset(&changes, 0, sizeof(changes));
+  changes.reset    = 6.0f;
+  changes.controls = &controls;
+
+  assert(!suil_controls_set(&controls, 1U, 1.0f));
+  suil_controls_flush(&controls, on_control, &changes);
+  assert(changes.n_changes == 1U);
+  assert(changes.values[0] == 1.0f);
+
+  changes.controls = NULL;
+  suil_controls_flush(&controls, on_control, &changes);
+  assert(changes.n_changes == 2U);
+  assert(changes.indices[1] == 1U);
+  assert(changes.values[1] == 6.0f);
+
+  suil_controls_cleanup(&controls);
+}
+
+int
+main(void)
+{
+  test_empty();
+  test_coalesce();
+  test_grow();
+  test_set_while_flushing();
+  return 0;
+}
@@ -0,0 +1,129 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#undef NDEBUG
+
+#include "suil_internal.h"
+
+#include <lv2/core/lv2.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_URIS 24U
+
+static void
+test_sizes(void)
+{
+  // Tables are a power of 2 at most half full, so probing always terminates
+  for (uint32_t capacity = 0U; capacity < 100U; ++capacity) {
+    const uint32_t n_slots = suil_features_n_slots(capacity);
+
+    assert(n_slots >= 4U);
+    assert(n_slots >= 2U * capacity);
+    assert(!(n_slots & (n_slots - 1U)));
+  }
+
+  assert(suil_features_size(0U, 4U) ==
+         sizeof(LV2_Feature*) + (4U * sizeof(uint32_t)));
+}
+
+static void
+test_add_get(void)
+{
+  const uint32_t capacity = N_URIS;
+  const uint32_t n_slots  = suil_features_n_slots(capacity);
+  void* const    storage  = calloc(1, suil_features_size(capacity, n_slots));
+  assert(storage);
+
+  SuilFeatures features;
+  suil_features_init(&features, storage, capacity, n_slots);
+  assert(!features.n_features);
+  assert(!suil_get_feature(&features, "urn:suil:test:extra"));
+
+  // Add features with distinct URIs that share a common prefix
+  char uris[N_URIS][32];
+  int  data[N_URIS];
+  for (uint32_t i = 0U; i < N_URIS; ++i) {
+    snprintf(uris[i], sizeof(uris[i]), "urn:suil:test:%u", i);
+    suil_add_feature(&features, uris[i], &data[i]);
+    assert(features.n_features == i + 1U);
+    assert(!features.array[i + 1U]);
+  }
+
+  // Every feature is found by URI, and the array is in the order added
+  for (uint32_t i = 0U; i < N_URIS; ++i) {
+    assert(suil_get_feature(&features, uris[i]) == &data[i]);
+    assert(features.array[i] == &features.storage[i]);
+    assert(features.array[i]->URI == uris[i]);
+    assert(features.array[i]->data == &data[i]);
+  }
+
+  assert(!suil_get_feature(&features, "urn:suil:test:missing"));
+
+  // Adding a feature that is already present replaces its data in place
+  int replacement = 0;
+  suil_add_feature(&features, "urn:suil:test:3", &replacement);
+  assert(features.n_features == N_URIS);
+  assert(features.array[3]->data == &replacement);
+  assert(suil_get_feature(&features, uris[3]) == &replacement);
+
+  // Adding a new feature beyond the capacity is ignored
+  suil_add_feature(&features, "urn:suil:test:extra", &replacement);
+  assert(features.n_features == N_URIS);
+  assert(!features.array[N_URIS]);
+  assert(!suil_get_feature(&features, "urn:suil:test:extra"));
+
+  free(storage);
+}
+
+static void
+test_collisions(void)
+{
+  const uint32_t n_slots  = 4U;
+  const uint32_t capacity = 2U;
+  void* const    storage  = calloc(1, suil_features_size(capacity, n_slots));
+  assert(storage);
+
+  SuilFeatures features;
+  suil_features_init(&features, storage, capacity, n_slots);
+
+  // These URIs all hash to the same slot, so lookups must probe past others
+  const char* const a_uri       = "urn:suil:test:0";
+  const char* const b_uri       = "urn:suil:test:4";
+  const char* const missing_uri = "urn:suil:test:8";
+  assert((suil_hash(a_uri) & 3U) == (suil_hash(b_uri) & 3U));
+  assert((suil_hash(a_uri) & 3U) == (suil_hash(missing_uri) & 3U));
+
+  int a = 0;
+  int b = 0;
+  suil_add_feature(&features, a_uri, &a);
+  suil_add_feature(&features, b_uri, &b);
+  assert(suil_get_feature(&features, a_uri) == &a);
+  assert(suil_get_feature(&features, b_uri) == &b);
+  assert(!suil_get_feature(&features, missing_uri));
+
+  free(storage);
+}
+
+static void
+test_hash(void)
+{
+  // FNV-1a test vectors
+  assert(suil_hash("") == 2166136261U);
+  assert(suil_hash("a") == 0xE40C292CU);
+  assert(suil_hash("foobar") == 0xBF9CF968U);
+}
+
+int
+main(void)
+{
+  test_sizes();
+  test_add_get();
+  test_collisions();
+  test_hash();
+  return 0;
+}
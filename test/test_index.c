@@ -0,0 +1,133 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#undef NDEBUG
+
+#include <lv2/ui/ui.h>
+#include <suil/suil.h>
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define N_FAKE_UIS 3U
+
+/// URIs of the UIs in the fake library, in order
+static const char* const fake_ui_uris[N_FAKE_UIS] = {
+  "urn:suil:test:echo",
+  "urn:suil:test:silent",
+  "urn:suil:test:failure",
+};
+
+static void
+write_func(SuilController controller,
+           uint32_t       port_index,
+           uint32_t       buffer_size,
+           uint32_t       protocol,
+           const void*    buffer)
+{
+  (void)controller;
+  (void)port_index;
+  (void)buffer_size;
+  (void)protocol;
+  (void)buffer;
+}
+
+static void
+on_ui(void* const data, const char* const ui_uri)
+{
+  unsigned* const n_uis = (unsigned*)data;
+
+  assert(*n_uis < N_FAKE_UIS);
+  assert(!strcmp(ui_uri, fake_ui_uris[*n_uis]));
+  ++*n_uis;
+}
+
+static SuilInstance*
+new_instance(SuilHost* const   host,
+             const char* const ui_path,
+             const char* const ui_uri)
+{
+  return suil_instance_new(host,
+                           NULL,
+                           NULL,
+                           "urn:suil:test:plugin",
+                           ui_uri,
+                           LV2_UI__X11UI,
+                           "",
+                           ui_path,
+                           NULL);
+}
+
+static void
+test_list_uis(const char* const ui_path)
+{
+  SuilHost* const host = suil_host_new(write_func, NULL, NULL, NULL);
+  assert(host);
+
+  // Every UI is listed in the order of the library
+  unsigned n_uis = 0U;
+  assert(!suil_library_list_uis(host, ui_path, on_ui, &n_uis));
+  assert(n_uis == N_FAKE_UIS);
+
+  // Listing a library that is in use doesn't load it again
+  SuilInstance* const instance =
+    new_instance(host, ui_path, "urn:suil:test:echo");
+  assert(instance);
+
+  n_uis = 0U;
+  assert(!suil_library_list_uis(host, ui_path, on_ui, &n_uis));
+  assert(n_uis == N_FAKE_UIS);
+
+  const SuilCacheStats stats = suil_host_get_cache_stats(host);
+  assert(stats.library_hits == 1U);
+  assert(stats.library_misses == 2U);
+
+  // Libraries that can't be loaded are errors
+  n_uis = 0U;
+  assert(suil_library_list_uis(host, "/does/not/exist", on_ui, &n_uis));
+  assert(!n_uis);
+
+  suil_instance_free(instance);
+  suil_host_free(host);
+}
+
+static void
+test_lookup(const char* const ui_path)
+{
+  SuilHost* const host = suil_host_new(write_func, NULL, NULL, NULL);
+  assert(host);
+
+  // Every UI in the index is found, only the failing one doesn't instantiate
+  SuilInstance* instances[N_FAKE_UIS] = {NULL, NULL, NULL};
+  for (unsigned i = 0U; i < N_FAKE_UIS; ++i) {
+    instances[i] = new_instance(host, ui_path, fake_ui_uris[i]);
+    assert(!instances[i] == !strcmp(fake_ui_uris[i], "urn:suil:test:failure"));
+  }
+
+  // UIs that aren't in the index aren't found, even with a common prefix
+  assert(!new_instance(host, ui_path, "urn:suil:test:"));
+  assert(!new_instance(host, ui_path, "urn:suil:test:echoes"));
+  assert(!new_instance(host, ui_path, ""));
+
+  const SuilCacheStats stats = suil_host_get_cache_stats(host);
+  assert(stats.descriptor_hits == N_FAKE_UIS - 1U);
+  assert(stats.descriptor_misses == 4U);
+
+  for (unsigned i = 0U; i < N_FAKE_UIS; ++i) {
+    suil_instance_free(instances[i]);
+  }
+
+  suil_host_free(host);
+}
+
+int
+main(int argc, char** argv)
+{
+  assert(argc == 2);
+
+  test_list_uis(argv[1]);
+  test_lookup(argv[1]);
+  return 0;
+}
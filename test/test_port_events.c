@@ -0,0 +1,187 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#undef NDEBUG
+
+#include <lv2/ui/ui.h>
+#include <suil/suil.h>
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define MAX_WRITES 8U
+
+/// Writes from the fake UI, which echoes every port event it receives
+typedef struct {
+  uint32_t n_writes;            ///< Number of writes received
+  uint32_t indices[MAX_WRITES]; ///< Port index of each write
+  uint32_t formats[MAX_WRITES]; ///< Format of each write
+  float    values[MAX_WRITES];  ///< Value of each float write
+  char     last_data[8];        ///< Payload of the last write
+  uint32_t last_size;           ///< Size of the last write
+} Writes;
+
+static void
+write_func(SuilController controller,
+           uint32_t       port_index,
+           uint32_t       buffer_size,
+           uint32_t       protocol,
+           const void*    buffer)
+{
+  Writes* const writes = (Writes*)controller;
+
+  assert(writes->n_writes < MAX_WRITES);
+  assert(buffer_size <= sizeof(writes->last_data));
+  writes->indices[writes->n_writes] = port_index;
+  writes->formats[writes->n_writes] = protocol;
+  if (!protocol && buffer_size == sizeof(float)) {
+    memcpy(&writes->values[writes->n_writes], buffer, sizeof(float));
+  }
+
+  memcpy(writes->last_data, buffer, buffer_size);
+  writes->last_size = buffer_size;
+  ++writes->n_writes;
+}
+
+static SuilInstance*
+new_instance(SuilHost* const   host,
+             Writes* const     writes,
+             const char* const ui_path,
+             const char* const ui_uri)
+{
+  return suil_instance_new(host,
+                           writes,
+                           NULL,
+                           "urn:suil:test:plugin",
+                           ui_uri,
+                           LV2_UI__X11UI,
+                           "",
+                           ui_path,
+                           NULL);
+}
+
+static void
+test_port_events(const char* const ui_path)
+{
+  SuilHost* const host = suil_host_new(write_func, NULL, NULL, NULL);
+  assert(host);
+
+  Writes writes;
+  memset(&writes, 0, sizeof(writes));
+
+  SuilInstance* const instance =
+    new_instance(host, &writes, ui_path, "urn:suil:test:echo");
+  assert(instance);
+
+  // Events are delivered in order, as with suil_instance_port_event()
+  const float         values[3] = {1.0f, 2.0f, 3.0f};
+  const char          text[]    = "text";
+  const SuilPortEvent events[4] = {
+    {4U, sizeof(float), 0U, &values[0]},
+    {2U, sizeof(float), 0U, &values[1]},
+    {7U, sizeof(text), 9U, text},
+    {2U, sizeof(float), 0U, &values[2]},
+  };
+
+  suil_instance_port_events(instance, events, 4U);
+  assert(writes.n_writes == 4U);
+  assert(writes.indices[0] == 4U);
+  assert(writes.values[0] == 1.0f);
+  assert(writes.indices[1] == 2U);
+  assert(writes.values[1] == 2.0f);
+  assert(writes.indices[2] == 7U);
+  assert(writes.formats[2] == 9U);
+  assert(writes.indices[3] == 2U);
+  assert(writes.values[3] == 3.0f);
+
+  // Nothing happens for an empty batch
+  suil_instance_port_events(instance, NULL, 0U);
+  assert(writes.n_writes == 4U);
+
+  suil_instance_free(instance);
+  suil_host_free(host);
+}
+
+static void
+test_no_port_event(const char* const ui_path)
+{
+  SuilHost* const host = suil_host_new(write_func, NULL, NULL, NULL);
+  assert(host);
+
+  Writes writes;
+  memset(&writes, 0, sizeof(writes));
+
+  SuilInstance* const instance =
+    new_instance(host, &writes, ui_path, "urn:suil:test:silent");
+  assert(instance);
+
+  // Events for a UI without a port_event function are dropped
+  const float         value     = 1.0f;
+  const SuilPortEvent events[2] = {
+    {0U, sizeof(float), 0U, &value},
+    {1U, sizeof(float), 0U, &value},
+  };
+
+  suil_instance_port_events(instance, events, 2U);
+  suil_instance_port_event(instance, 0U, sizeof(value), 0U, &value);
+  assert(!writes.n_writes);
+
+  suil_instance_free(instance);
+  suil_host_free(host);
+}
+
+static void
+test_coalesced(const char* const ui_path)
+{
+  SuilHost* const host = suil_host_new(write_func, NULL, NULL, NULL);
+  assert(host);
+  suil_host_set_coalesce_controls(host, true);
+
+  Writes writes;
+  memset(&writes, 0, sizeof(writes));
+
+  SuilInstance* const instance =
+    new_instance(host, &writes, ui_path, "urn:suil:test:echo");
+  assert(instance);
+
+  // Only other events are delivered immediately
+  const float         values[3] = {1.0f, 2.0f, 3.0f};
+  const char          text[]    = "text";
+  const SuilPortEvent events[4] = {
+    {4U, sizeof(float), 0U, &values[0]},
+    {2U, sizeof(float), 0U, &values[1]},
+    {7U, sizeof(text), 9U, text},
+    {2U, sizeof(float), 0U, &values[2]},
+  };
+
+  suil_instance_port_events(instance, events, 4U);
+  assert(writes.n_writes == 1U);
+  assert(writes.indices[0] == 7U);
+  assert(writes.last_size == sizeof(text));
+  assert(!strcmp(writes.last_data, text));
+
+  // Controls are delivered by the next flush, with their latest values
+  suil_instance_flush(instance);
+  assert(writes.n_writes == 3U);
+  assert(writes.indices[1] == 2U);
+  assert(writes.values[1] == 3.0f);
+  assert(writes.indices[2] == 4U);
+  assert(writes.values[2] == 1.0f);
+
+  suil_instance_free(instance);
+  suil_host_free(host);
+}
+
+int
+main(int argc, char** argv)
+{
+  assert(argc == 2);
+
+  test_port_events(argv[1]);
+  test_no_port_event(argv[1]);
+  test_coalesced(argv[1]);
+  return 0;
+}
@@ -0,0 +1,100 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#undef NDEBUG
+
+#include <lv2/ui/ui.h>
+#include <suil/suil.h>
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+static void
+write_func(SuilController controller,
+           uint32_t       port_index,
+           uint32_t       buffer_size,
+           uint32_t       protocol,
+           const void*    buffer)
+{
+  (void)controller;
+  (void)port_index;
+  (void)buffer_size;
+  (void)protocol;
+  (void)buffer;
+}
+
+static SuilInstance*
+new_wrapped_instance(SuilHost* const host, const char* const ui_path)
+{
+  // The fake wrapper module is built in place of the one for this wrapping
+  return suil_instance_new(host,
+                           NULL,
+                           LV2_UI__Gtk3UI,
+                           "urn:suil:test:plugin",
+                           "urn:suil:test:echo",
+                           LV2_UI__X11UI,
+                           "",
+                           ui_path,
+                           NULL);
+}
+
+static void
+test_preload(const char* const ui_path)
+{
+  SuilHost* const host = suil_host_new(write_func, NULL, NULL, NULL);
+  assert(host);
+
+  // Unknown container types can't be preloaded
+  assert(suil_host_preload(host, "urn:suil:test:UI"));
+
+  // Preloading again waits for the previous preload to finish
+  assert(!suil_host_preload(host, LV2_UI__Gtk3UI));
+  assert(!suil_host_preload(host, LV2_UI__Gtk3UI));
+
+  SuilCacheStats stats = suil_host_get_cache_stats(host);
+  assert(stats.module_misses == 1U);
+
+  // Instances use the module that was loaded in the background
+  SuilInstance* const instance = new_wrapped_instance(host, ui_path);
+  assert(instance);
+
+  // The fake UI's widget is its handle, so this shows that it was wrapped
+  assert(suil_instance_get_widget(instance) !=
+         suil_instance_get_handle(instance));
+
+  stats = suil_host_get_cache_stats(host);
+  assert(stats.module_misses == 1U);
+  assert(stats.module_hits >= 1U);
+
+  // The module stays loaded in the host after the instance is freed
+  suil_instance_free(instance);
+
+  SuilInstance* const next = new_wrapped_instance(host, ui_path);
+  assert(next);
+  stats = suil_host_get_cache_stats(host);
+  assert(stats.module_misses == 1U);
+
+  suil_instance_free(next);
+  suil_host_free(host);
+}
+
+static void
+test_free_while_preloading(void)
+{
+  // Freeing the host waits for the preload to finish
+  SuilHost* const host = suil_host_new(write_func, NULL, NULL, NULL);
+  assert(host);
+  assert(!suil_host_preload(host, LV2_UI__Gtk3UI));
+  suil_host_free(host);
+}
+
+int
+main(int argc, char** argv)
+{
+  assert(argc == 2);
+
+  test_preload(argv[1]);
+  test_free_while_preloading();
+  return 0;
+}
@@ -0,0 +1,242 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#undef NDEBUG
+
+#include "suil_internal.h"
+#include "thread.h"
+
+#include <suil/suil.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#define N_THREADED_EVENTS 10000U
+
+/// Events received from a queue
+typedef struct {
+  uint32_t n_events;    ///< Number of events received
+  uint32_t port_index;  ///< Port index of the last event
+  uint32_t buffer_size; ///< Size of the last event
+  uint32_t format;      ///< Format of the last event
+  char     data[32];    ///< Payload of the last event
+} Received;
+
+static void
+on_event(void* const       data,
+         const uint32_t    port_index,
+         const uint32_t    buffer_size,
+         const uint32_t    format,
+         const void* const buffer)
+{
+  Received* const received = (Received*)data;
+
+  assert(buffer_size <= sizeof(received->data));
+  received->port_index  = port_index;
+  received->buffer_size = buffer_size;
+  received->format      = format;
+  memcpy(received->data, buffer, buffer_size);
+  ++received->n_events;
+}
+
+static void
+on_release(void* const data, SuilBuffer* const buffer)
+{
+  *(SuilBuffer**)data = buffer;
+}
+
+static void
+test_disabled(void)
+{
+  SuilQueue queue;
+  assert(!suil_queue_init(&queue, 0U));
+  assert(!queue.buf);
+
+  const float value = 1.0f;
+  assert(suil_queue_write(&queue, 0U, sizeof(value), 0U, &value));
+
+  Received received = {0U, 0U, 0U, 0U, {0}};
+  suil_queue_drain(&queue, on_event, &received);
+  assert(!received.n_events);
+
+  suil_queue_cleanup(&queue);
+}
+
+static void
+test_write_drain(void)
+{
+  SuilQueue queue;
+  assert(!suil_queue_init(&queue, 100U));
+  assert(queue.size >= 100U);
+  assert(!(queue.size & (queue.size - 1U)));
+
+  const float value  = 0.5f;
+  const char  text[] = "text";
+  assert(!suil_queue_write(&queue, 3U, sizeof(value), 0U, &value));
+  assert(!suil_queue_write(&queue, 4U, sizeof(text), 7U, text));
+
+  // Events are delivered in order, and only once
+  Received received = {0U, 0U, 0U, 0U, {0}};
+  suil_queue_drain(&queue, on_event, &received);
+  assert(received.n_events == 2U);
+  assert(received.port_index == 4U);
+  assert(received.buffer_size == sizeof(text));
+  assert(received.format == 7U);
+  assert(!strcmp(received.data, text));
+
+  suil_queue_drain(&queue, on_event, &received);
+  assert(received.n_events == 2U);
+
+  // An event that could never fit is rejected
+  char big[256] = {0};
+  assert(suil_queue_write(&queue, 0U, sizeof(big), 0U, big));
+
+  suil_queue_cleanup(&queue);
+}
+
+static void
+test_full(void)
+{
+  SuilQueue queue;
+  assert(!suil_queue_init(&queue, 64U));
+  assert(queue.size == 64U);
+
+  // Each record is a 16 byte header and a padded payload
+  const uint32_t value = 1U;
+  assert(!suil_queue_write(&queue, 0U, sizeof(value), 0U, &value));
+  assert(!suil_queue_write(&queue, 1U, sizeof(value), 0U, &value));
+  assert(suil_queue_write(&queue, 2U, sizeof(value), 0U, &value));
+
+  // Draining makes space again
+  Received received = {0U, 0U, 0U, 0U, {0}};
+  suil_queue_drain(&queue, on_event, &received);
+  assert(received.n_events == 2U);
+  assert(received.port_index == 1U);
+  assert(!suil_queue_write(&queue, 2U, sizeof(value), 0U, &value));
+
+  suil_queue_cleanup(&queue);
+}
+
+static void
+test_wrap(void)
+{
+  SuilQueue queue;
+  assert(!suil_queue_init(&queue, 128U));
+
+  // Write events of every size so records are padded to the end of the ring
+  Received received = {0U, 0U, 0U, 0U, {0}};
+  for (uint32_t i = 0U; i < 1000U; ++i) {
+    char           data[32] = {0};
+    const uint32_t size     = 1U + (i % (uint32_t)sizeof(data));
+
+    memset(data, (int)(i % 128U), size);
+    assert(!suil_queue_write(&queue, i, size, 0U, data));
+
+    suil_queue_drain(&queue, on_event, &received);
+    assert(received.n_events == i + 1U);
+    assert(received.port_index == i);
+    assert(received.buffer_size == size);
+    assert(!memcmp(received.data, data, size));
+  }
+
+  suil_queue_cleanup(&queue);
+}
+
+static void
+test_buffer(void)
+{
+  SuilQueue queue;
+  assert(!suil_queue_init(&queue, 256U));
+
+  SuilBuffer* released = NULL;
+  SuilBuffer* buffer   = suil_buffer_new(16U, on_release, &released);
+  assert(buffer);
+  memcpy(suil_buffer_get_data(buffer), "buffer", 7U);
+
+  // The queue holds a reference until the event is delivered
+  assert(!suil_queue_write_buffer(&queue, 5U, 7U, 9U, buffer));
+  suil_buffer_unref(buffer);
+  assert(!released);
+
+  Received received = {0U, 0U, 0U, 0U, {0}};
+  suil_queue_drain(&queue, on_event, &received);
+  assert(received.n_events == 1U);
+  assert(received.port_index == 5U);
+  assert(received.buffer_size == 7U);
+  assert(received.format == 9U);
+  assert(!strcmp(received.data, "buffer"));
+  assert(released == buffer);
+
+  // Cleaning up drops the references of events that were never delivered
+  released = NULL;
+  suil_buffer_ref(buffer);
+  assert(!suil_queue_write_buffer(&queue, 5U, 7U, 9U, buffer));
+  suil_buffer_unref(buffer);
+  suil_queue_cleanup(&queue);
+  assert(released == buffer);
+
+  suil_buffer_free(buffer);
+}
+
+static void
+write_events(void* const data)
+{
+  SuilQueue* const queue = (SuilQueue*)data;
+
+  for (uint32_t i = 0U; i < N_THREADED_EVENTS;) {
+    if (!suil_queue_write(queue, i, sizeof(i), 0U, &i)) {
+      ++i;
+    }
+  }
+}
+
+static void
+on_threaded_event(void* const       data,
+                  const uint32_t    port_index,
+                  const uint32_t    buffer_size,
+                  const uint32_t    format,
+                  const void* const buffer)
+{
+  uint32_t* const n_events = (uint32_t*)data;
+  uint32_t        value    = 0U;
+
+  (void)format;
+
+  assert(buffer_size == sizeof(value));
+  memcpy(&value, buffer, sizeof(value));
+  assert(port_index == *n_events);
+  assert(value == *n_events);
+  ++*n_events;
+}
+
+static void
+test_threaded(void)
+{
+  SuilQueue queue;
+  assert(!suil_queue_init(&queue, 256U));
+
+  // Every event arrives intact and in order while the writer runs
+  SuilThread writer;
+  assert(!suil_thread_start(&writer, write_events, &queue));
+
+  uint32_t n_events = 0U;
+  while (n_events < N_THREADED_EVENTS) {
+    suil_queue_drain(&queue, on_threaded_event, &n_events);
+  }
+
+  suil_thread_join(&writer);
+  suil_queue_cleanup(&queue);
+}
+
+int
+main(void)
+{
+  test_disabled();
+  test_write_drain();
+  test_full();
+  test_wrap();
+  test_buffer();
+  test_threaded();
+  return 0;
+}
@@ -0,0 +1,367 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#undef NDEBUG
+
+#include "scheduler.h"
+
+#include <suil/suil.h>
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Fake timer state and clock, since the scheduler is only driven by run()
+static unsigned n_timer_starts = 0U;
+static unsigned n_timer_stops  = 0U;
+static uint64_t fake_time      = 0U;
+
+/// A registered function that counts its calls and takes a given time
+typedef struct {
+  SuilFrameEntry  entry;   ///< Entry registered with the scheduler
+  SuilFrameEntry* remove;  ///< Entry to remove when called, or null
+  unsigned        n_calls; ///< Number of times called
+  uint64_t        cost;    ///< Fake time taken by each call
+} Client;
+
+/// Watchdog calls, and the stats of the last one
+typedef struct {
+  unsigned       n_calls;  ///< Number of times called
+  SuilController owner;    ///< Controller from the last call
+  uint32_t       throttle; ///< Throttle from the last call
+} Watchdog;
+
+static void*
+start_timer(SuilScheduler* const scheduler)
+{
+  (void)scheduler;
+  ++n_timer_starts;
+  return &n_timer_starts;
+}
+
+static void
+stop_timer(void* const timer)
+{
+  assert(timer == &n_timer_starts);
+  ++n_timer_stops;
+}
+
+static uint64_t
+fake_now(void)
+{
+  return fake_time;
+}
+
+static void
+on_frame(void* const data)
+{
+  Client* const client = (Client*)data;
+
+  ++client->n_calls;
+  fake_time += client->cost;
+  if (client->remove) {
+    suil_scheduler_remove(client->remove);
+  }
+}
+
+static void
+on_watchdog(void* const                data,
+            const SuilController       owner,
+            const SuilIdleStats* const stats)
+{
+  Watchdog* const watchdog = (Watchdog*)data;
+
+  ++watchdog->n_calls;
+  watchdog->owner    = owner;
+  watchdog->throttle = stats->throttle;
+}
+
+static SuilScheduler*
+new_scheduler(void)
+{
+  SuilScheduler* const scheduler =
+    (SuilScheduler*)calloc(1, sizeof(SuilScheduler));
+
+  assert(scheduler);
+  scheduler->rate = SUIL_FRAME_RATE;
+  scheduler->refs = 1U; // Held by the "host"
+  return scheduler;
+}
+
+static void
+add_client(SuilScheduler* const scheduler,
+           Client* const        client,
+           const float          update_rate)
+{
+  suil_scheduler_add(scheduler,
+                     &client->entry,
+                     client,
+                     on_frame,
+                     client,
+                     update_rate,
+                     start_timer,
+                     stop_timer);
+}
+
+static void
+test_divisor(void)
+{
+  SuilScheduler scheduler;
+  memset(&scheduler, 0, sizeof(scheduler));
+  scheduler.rate = 60U;
+
+  assert(suil_scheduler_divisor(&scheduler, 60.0f) == 1U);
+  assert(suil_scheduler_divisor(&scheduler, 30.0f) == 2U);
+  assert(suil_scheduler_divisor(&scheduler, 25.0f) == 2U);
+  assert(suil_scheduler_divisor(&scheduler, 20.0f) == 3U);
+  assert(suil_scheduler_divisor(&scheduler, 1000.0f) == 1U);
+  assert(suil_scheduler_divisor(&scheduler, 0.0f) == 1U);
+  assert(suil_scheduler_divisor(&scheduler, 0.0001f) == UINT16_MAX);
+  assert(suil_scheduler_interval(&scheduler) == 17U);
+
+  scheduler.rate = 2000U;
+  assert(suil_scheduler_interval(&scheduler) == 1U);
+}
+
+static void
+test_run(void)
+{
+  n_timer_starts = 0U;
+  n_timer_stops  = 0U;
+
+  SuilScheduler* const scheduler = new_scheduler();
+  Client               clients[3];
+  memset(clients, 0, sizeof(clients));
+
+  // Every client shares the timer started by the first
+  add_client(scheduler, &clients[0], 60.0f);
+  add_client(scheduler, &clients[1], 30.0f);
+  add_client(scheduler, &clients[2], 20.0f);
+  assert(n_timer_starts == 1U);
+  assert(scheduler->refs == 4U);
+
+  // Each client is called on the divisor of the frame rate nearest its rate
+  for (unsigned i = 0U; i < 12U; ++i) {
+    suil_scheduler_run(scheduler);
+  }
+
+  assert(clients[0].n_calls == 12U);
+  assert(clients[1].n_calls == 6U);
+  assert(clients[2].n_calls == 4U);
+
+  // The scheduler outlives the host while entries are registered
+  suil_scheduler_unref(scheduler);
+  suil_scheduler_remove(&clients[0].entry);
+  suil_scheduler_remove(&clients[1].entry);
+  assert(!n_timer_stops);
+
+  // Removing the last entry stops the timer and frees the scheduler
+  suil_scheduler_remove(&clients[2].entry);
+  assert(n_timer_stops == 1U);
+  assert(!clients[2].entry.scheduler);
+
+  // Removing an entry that isn't registered does nothing
+  suil_scheduler_remove(&clients[2].entry);
+  assert(n_timer_stops == 1U);
+}
+
+static void
+test_remove_while_running(void)
+{
+  n_timer_starts = 0U;
+  n_timer_stops  = 0U;
+
+  SuilScheduler* const scheduler = new_scheduler();
+  Client               clients[2];
+  memset(clients, 0, sizeof(clients));
+
+  // Entries are added to the front, so clients[1] runs first
+  add_client(scheduler, &clients[0], 60.0f);
+  add_client(scheduler, &clients[1], 60.0f);
+
+  // An entry can remove itself and the next entry in the same frame
+  clients[1].remove = &clients[0].entry;
+  suil_scheduler_run(scheduler);
+  assert(clients[1].n_calls == 1U);
+  assert(!clients[0].n_calls);
+
+  clients[1].remove = &clients[1].entry;
+  suil_scheduler_run(scheduler);
+  assert(clients[1].n_calls == 2U);
+  assert(!scheduler->entries);
+  assert(n_timer_stops == 1U);
+
+  suil_scheduler_unref(scheduler);
+}
+
+static void
+test_visibility(void)
+{
+  SuilScheduler* const scheduler = new_scheduler();
+  Client               client;
+  memset(&client, 0, sizeof(client));
+
+  // Hidden entries run at the hidden rate
+  suil_scheduler_set_visible(&client.entry, false);
+  add_client(scheduler, &client, 30.0f);
+  assert(client.entry.divisor == 60U);
+
+  for (unsigned i = 0U; i < 120U; ++i) {
+    suil_scheduler_run(scheduler);
+  }
+
+  assert(client.n_calls == 2U);
+
+  // Showing an entry runs it on the next frame, then at its normal rate
+  scheduler->frame = 61U;
+  suil_scheduler_set_visible(&client.entry, true);
+  assert(client.entry.divisor == 2U);
+  assert(client.entry.due);
+
+  suil_scheduler_run(scheduler);
+  assert(client.n_calls == 3U);
+  suil_scheduler_run(scheduler);
+  assert(client.n_calls == 4U);
+  suil_scheduler_run(scheduler);
+  assert(client.n_calls == 4U);
+
+  // Entries already slower than the hidden rate aren't sped up
+  suil_scheduler_remove(&client.entry);
+  add_client(scheduler, &client, 0.1f);
+  suil_scheduler_set_visible(&client.entry, false);
+  assert(client.entry.divisor == 600U);
+
+  suil_scheduler_remove(&client.entry);
+  suil_scheduler_unref(scheduler);
+}
+
+static void
+test_throttle(void)
+{
+  Watchdog watchdog;
+  memset(&watchdog, 0, sizeof(watchdog));
+
+  SuilScheduler* const scheduler = new_scheduler();
+  scheduler->now           = fake_now;
+  scheduler->budget        = 1000U;
+  scheduler->watchdog      = on_watchdog;
+  scheduler->watchdog_data = &watchdog;
+
+  Client client;
+  memset(&client, 0, sizeof(client));
+  add_client(scheduler, &client, 60.0f);
+  assert(client.entry.stats.throttle == 1U);
+
+  // A client over budget is slowed down until it reaches the maximum
+  client.cost = 5000U;
+  for (unsigned i = 0U; i < 2000U; ++i) {
+    suil_scheduler_run(scheduler);
+  }
+
+  assert(client.entry.stats.throttle == SUIL_MAX_THROTTLE);
+  assert(client.entry.divisor == SUIL_MAX_THROTTLE);
+  assert(client.entry.stats.max_time == 5000U);
+  assert(watchdog.n_calls == 6U);
+  assert(watchdog.owner == &client);
+  assert(watchdog.throttle == SUIL_MAX_THROTTLE);
+
+  // A client well under budget recovers to its full rate
+  client.cost = 10U;
+  for (unsigned i = 0U; i < 200000U; ++i) {
+    suil_scheduler_run(scheduler);
+  }
+
+  assert(client.entry.stats.throttle == 1U);
+  assert(client.entry.divisor == 1U);
+  assert(client.entry.stats.average_time < 500U);
+  assert(client.entry.stats.max_time == 5000U);
+  assert(watchdog.n_calls == 12U);
+  assert(watchdog.throttle == 1U);
+
+  suil_scheduler_remove(&client.entry);
+  suil_scheduler_unref(scheduler);
+}
+
+static void
+test_readd(void)
+{
+  Watchdog watchdog;
+  memset(&watchdog, 0, sizeof(watchdog));
+
+  SuilScheduler* const scheduler = new_scheduler();
+  scheduler->now           = fake_now;
+  scheduler->budget        = 1000U;
+  scheduler->watchdog      = on_watchdog;
+  scheduler->watchdog_data = &watchdog;
+
+  Client client;
+  memset(&client, 0, sizeof(client));
+  add_client(scheduler, &client, 30.0f);
+
+  client.cost = 5000U;
+  for (unsigned i = 0U; i < 4000U; ++i) {
+    suil_scheduler_run(scheduler);
+  }
+
+  assert(client.entry.stats.throttle == SUIL_MAX_THROTTLE);
+  assert(client.entry.divisor == 2U * SUIL_MAX_THROTTLE);
+
+  // A throttled client stays throttled when it is removed and added again
+  const unsigned n_watchdog_calls = watchdog.n_calls;
+  suil_scheduler_remove(&client.entry);
+  add_client(scheduler, &client, 30.0f);
+  assert(client.entry.stats.throttle == SUIL_MAX_THROTTLE);
+  assert(client.entry.divisor == 2U * SUIL_MAX_THROTTLE);
+  assert(client.entry.stats.max_time == 5000U);
+
+  for (unsigned i = 0U; i < 4000U; ++i) {
+    suil_scheduler_run(scheduler);
+  }
+
+  assert(client.entry.stats.throttle == SUIL_MAX_THROTTLE);
+  assert(watchdog.n_calls == n_watchdog_calls);
+
+  suil_scheduler_remove(&client.entry);
+  suil_scheduler_unref(scheduler);
+}
+
+static void
+test_delay(void)
+{
+  SuilScheduler scheduler;
+  memset(&scheduler, 0, sizeof(scheduler));
+  scheduler.rate = 60U;
+
+  // Without a clock, there is never a delay
+  assert(!suil_scheduler_delay(&scheduler, 0U));
+
+  scheduler.now = fake_now;
+  fake_time     = 1000000000U;
+  assert(!suil_scheduler_delay(&scheduler, 0U));
+
+  // The delay is rounded up to the next millisecond after a frame has passed
+  const uint64_t last = fake_time;
+  fake_time += 1000000U;
+  assert(suil_scheduler_delay(&scheduler, last) == 16U);
+
+  fake_time = last + 16666000U;
+  assert(suil_scheduler_delay(&scheduler, last) == 1U);
+
+  fake_time = last + 16666666U;
+  assert(!suil_scheduler_delay(&scheduler, last));
+}
+
+int
+main(void)
+{
+  test_divisor();
+  test_run();
+  test_remove_while_running();
+  test_visibility();
+  test_throttle();
+  test_readd();
+  test_delay();
+  return 0;
+}
@@ -0,0 +1,120 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#undef NDEBUG
+
+#include <lv2/ui/ui.h>
+#include <suil/suil.h>
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Calls of the stats function, and the stats of the last one
+typedef struct {
+  unsigned          n_calls;    ///< Number of times called
+  SuilController    controller; ///< Controller from the last call
+  SuilInstanceStats stats;      ///< Stats from the last call
+} Reported;
+
+static void
+write_func(SuilController controller,
+           uint32_t       port_index,
+           uint32_t       buffer_size,
+           uint32_t       protocol,
+           const void*    buffer)
+{
+  (void)controller;
+  (void)port_index;
+  (void)buffer_size;
+  (void)protocol;
+  (void)buffer;
+}
+
+static void
+on_stats(void* const                    data,
+         const SuilController           controller,
+         const SuilInstanceStats* const stats)
+{
+  Reported* const reported = (Reported*)data;
+
+  ++reported->n_calls;
+  reported->controller = controller;
+  reported->stats      = *stats;
+}
+
+static SuilInstance*
+new_instance(SuilHost* const      host,
+             const SuilController controller,
+             const char* const    ui_path,
+             const char* const    ui_uri)
+{
+  return suil_instance_new(host,
+                           controller,
+                           NULL,
+                           "urn:suil:test:plugin",
+                           ui_uri,
+                           LV2_UI__X11UI,
+                           "",
+                           ui_path,
+                           NULL);
+}
+
+static void
+test_stats(const char* const ui_path)
+{
+  Reported        reported   = {0U, NULL, {0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U}};
+  int             controller = 0;
+  SuilHost* const host       = suil_host_new(write_func, NULL, NULL, NULL);
+  assert(host);
+
+  suil_host_set_stats_func(host, on_stats, &reported);
+
+  // Loading the library takes time, but the UI isn't wrapped or freed yet
+  SuilInstance* const instance =
+    new_instance(host, &controller, ui_path, "urn:suil:test:echo");
+  assert(instance);
+
+  const SuilInstanceStats stats = suil_instance_get_stats(instance);
+  assert(stats.load_time);
+  assert(!stats.open_wrapper_time);
+  assert(!stats.wrap_time);
+  assert(!stats.wrapper_free_time);
+  assert(!stats.cleanup_time);
+  assert(!stats.unload_time);
+  assert(!reported.n_calls);
+
+  // Freeing reports the creation times along with those of freeing
+  suil_instance_free(instance);
+  assert(reported.n_calls == 1U);
+  assert(reported.controller == &controller);
+  assert(reported.stats.load_time == stats.load_time);
+  assert(reported.stats.lookup_time == stats.lookup_time);
+  assert(reported.stats.features_time == stats.features_time);
+  assert(reported.stats.instantiate_time == stats.instantiate_time);
+  assert(!reported.stats.wrap_time);
+
+  // Instances that fail to instantiate are reported too
+  assert(!new_instance(host, &controller, ui_path, "urn:suil:test:failure"));
+  assert(reported.n_calls == 2U);
+  assert(reported.stats.load_time);
+
+  // Nothing is reported once the function is cleared
+  suil_host_set_stats_func(host, NULL, NULL);
+  SuilInstance* const silent =
+    new_instance(host, &controller, ui_path, "urn:suil:test:silent");
+  assert(silent);
+  suil_instance_free(silent);
+  assert(reported.n_calls == 2U);
+
+  suil_host_free(host);
+}
+
+int
+main(int argc, char** argv)
+{
+  assert(argc == 2);
+
+  test_stats(argv[1]);
+  return 0;
+}
@@ -0,0 +1,75 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#undef NDEBUG
+
+#include <lv2/ui/ui.h>
+#include <suil/suil.h>
+
+#include <assert.h>
+
+static void
+test_ui_type(void)
+{
+  assert(suil_ui_type(LV2_UI__GtkUI) == SUIL_UI_TYPE_GTK2);
+  assert(suil_ui_type(LV2_UI__Gtk3UI) == SUIL_UI_TYPE_GTK3);
+  assert(suil_ui_type(LV2_UI__Qt5UI) == SUIL_UI_TYPE_QT5);
+  assert(suil_ui_type(LV2_UI_PREFIX "Qt6UI") == SUIL_UI_TYPE_QT6);
+  assert(suil_ui_type(LV2_UI__X11UI) == SUIL_UI_TYPE_X11);
+  assert(suil_ui_type(LV2_UI_PREFIX "WindowsUI") == SUIL_UI_TYPE_WINDOWS);
+  assert(suil_ui_type(LV2_UI__CocoaUI) == SUIL_UI_TYPE_COCOA);
+
+  // Only exact URIs in the UI namespace are known
+  assert(suil_ui_type("") == SUIL_UI_TYPE_UNKNOWN);
+  assert(suil_ui_type(LV2_UI_PREFIX) == SUIL_UI_TYPE_UNKNOWN);
+  assert(suil_ui_type(LV2_UI_PREFIX "Gtk") == SUIL_UI_TYPE_UNKNOWN);
+  assert(suil_ui_type(LV2_UI_PREFIX "Gtk3UIs") == SUIL_UI_TYPE_UNKNOWN);
+  assert(suil_ui_type("urn:suil:test:X11UI") == SUIL_UI_TYPE_UNKNOWN);
+}
+
+static void
+test_ui_type_supported(void)
+{
+  // Every known type is supported natively
+  for (unsigned i = SUIL_UI_TYPE_GTK2; i <= SUIL_UI_TYPE_COCOA; ++i) {
+    assert(suil_ui_type_supported((SuilUIType)i, (SuilUIType)i) == 1U);
+  }
+
+  assert(suil_ui_type_supported(SUIL_UI_TYPE_GTK2, SUIL_UI_TYPE_X11) == 2U);
+  assert(suil_ui_type_supported(SUIL_UI_TYPE_GTK3, SUIL_UI_TYPE_X11) == 2U);
+  assert(suil_ui_type_supported(SUIL_UI_TYPE_QT5, SUIL_UI_TYPE_X11) == 2U);
+  assert(suil_ui_type_supported(SUIL_UI_TYPE_QT6, SUIL_UI_TYPE_X11) == 2U);
+  assert(suil_ui_type_supported(SUIL_UI_TYPE_QT5, SUIL_UI_TYPE_COCOA) == 2U);
+  assert(!suil_ui_type_supported(SUIL_UI_TYPE_GTK3, SUIL_UI_TYPE_QT5));
+  assert(!suil_ui_type_supported(SUIL_UI_TYPE_X11, SUIL_UI_TYPE_GTK2));
+
+  // Unknown and invalid types are never supported
+  assert(!suil_ui_type_supported(SUIL_UI_TYPE_UNKNOWN, SUIL_UI_TYPE_UNKNOWN));
+  assert(!suil_ui_type_supported(SUIL_UI_TYPE_GTK2, SUIL_UI_TYPE_UNKNOWN));
+  assert(!suil_ui_type_supported((SuilUIType)99, SUIL_UI_TYPE_X11));
+  assert(!suil_ui_type_supported(SUIL_UI_TYPE_GTK2, (SuilUIType)99));
+}
+
+static void
+test_ui_supported(void)
+{
+  // URIs are supported the same as their types
+  assert(suil_ui_supported(LV2_UI__Gtk3UI, LV2_UI__Gtk3UI) == 1U);
+  assert(suil_ui_supported(LV2_UI__GtkUI, LV2_UI__X11UI) == 2U);
+  assert(!suil_ui_supported(LV2_UI__Gtk3UI, LV2_UI__Qt5UI));
+
+  // Unknown types are only supported natively
+  assert(suil_ui_supported("urn:suil:test:UI", "urn:suil:test:UI") == 1U);
+  assert(!suil_ui_supported("urn:suil:test:UI", "urn:suil:test:OtherUI"));
+  assert(!suil_ui_supported("urn:suil:test:UI", LV2_UI__X11UI));
+  assert(!suil_ui_supported(LV2_UI__Gtk3UI, "urn:suil:test:UI"));
+}
+
+int
+main(void)
+{
+  test_ui_type();
+  test_ui_type_supported();
+  test_ui_supported();
+  return 0;
+}
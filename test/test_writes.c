@@ -0,0 +1,169 @@
+// Copyright 2026 David Robillard <d@drobilla.net>
+// SPDX-License-Identifier: ISC
+
+#undef NDEBUG
+
+#include <lv2/ui/ui.h>
+#include <suil/suil.h>
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define MAX_WRITES 8U
+
+/// Writes from the fake UI, which echoes every port event it receives
+typedef struct {
+  uint32_t n_writes;            ///< Number of writes received
+  uint32_t indices[MAX_WRITES]; ///< Port index of each write
+  uint32_t formats[MAX_WRITES]; ///< Format of each write
+  float    values[MAX_WRITES];  ///< Value of each float write
+} Writes;
+
+static void
+write_func(SuilController controller,
+           uint32_t       port_index,
+           uint32_t       buffer_size,
+           uint32_t       protocol,
+           const void*    buffer)
+{
+  Writes* const writes = (Writes*)controller;
+
+  assert(writes->n_writes < MAX_WRITES);
+  writes->indices[writes->n_writes] = port_index;
+  writes->formats[writes->n_writes] = protocol;
+  if (!protocol && buffer_size == sizeof(float)) {
+    memcpy(&writes->values[writes->n_writes], buffer, sizeof(float));
+  }
+
+  ++writes->n_writes;
+}
+
+/// Make the fake UI write a control value
+static void
+write_control(SuilInstance* const instance,
+              const uint32_t      port_index,
+              const float         value)
+{
+  suil_instance_port_event(instance, port_index, sizeof(value), 0U, &value);
+}
+
+static SuilInstance*
+new_instance(SuilHost* const   host,
+             Writes* const     writes,
+             const char* const ui_path)
+{
+  return suil_instance_new(host,
+                           writes,
+                           NULL,
+                           "urn:suil:test:plugin",
+                           "urn:suil:test:echo",
+                           LV2_UI__X11UI,
+                           "",
+                           ui_path,
+                           NULL);
+}
+
+static void
+test_coalesce(const char* const ui_path)
+{
+  SuilHost* const host = suil_host_new(write_func, NULL, NULL, NULL);
+  assert(host);
+  suil_host_set_coalesce_writes(host, true);
+
+  Writes writes;
+  memset(&writes, 0, sizeof(writes));
+
+  SuilInstance* const instance = new_instance(host, &writes, ui_path);
+  assert(instance);
+
+  // Control writes are held until the next flush
+  write_control(instance, 3U, 1.0f);
+  write_control(instance, 1U, 2.0f);
+  write_control(instance, 3U, 3.0f);
+  assert(!writes.n_writes);
+
+  // Only the latest value of each port is forwarded, in index order
+  suil_instance_flush(instance);
+  assert(writes.n_writes == 2U);
+  assert(writes.indices[0] == 1U);
+  assert(writes.values[0] == 2.0f);
+  assert(writes.indices[1] == 3U);
+  assert(writes.values[1] == 3.0f);
+
+  suil_instance_flush(instance);
+  assert(writes.n_writes == 2U);
+
+  // Other writes are forwarded immediately, after any pending controls
+  const char text[] = "text";
+  write_control(instance, 5U, 4.0f);
+  suil_instance_port_event(instance, 6U, sizeof(text), 9U, text);
+  assert(writes.n_writes == 4U);
+  assert(writes.indices[2] == 5U);
+  assert(writes.values[2] == 4.0f);
+  assert(writes.indices[3] == 6U);
+  assert(writes.formats[3] == 9U);
+
+  suil_instance_free(instance);
+  assert(writes.n_writes == 4U);
+  suil_host_free(host);
+}
+
+static void
+test_flush_on_free(const char* const ui_path)
+{
+  SuilHost* const host = suil_host_new(write_func, NULL, NULL, NULL);
+  assert(host);
+  suil_host_set_coalesce_writes(host, true);
+
+  Writes writes;
+  memset(&writes, 0, sizeof(writes));
+
+  SuilInstance* const instance = new_instance(host, &writes, ui_path);
+  assert(instance);
+
+  // Pending writes are forwarded when the instance is freed
+  write_control(instance, 2U, 5.0f);
+  assert(!writes.n_writes);
+  suil_instance_free(instance);
+  assert(writes.n_writes == 1U);
+  assert(writes.indices[0] == 2U);
+  assert(writes.values[0] == 5.0f);
+
+  suil_host_free(host);
+}
+
+static void
+test_disabled(const char* const ui_path)
+{
+  SuilHost* const host = suil_host_new(write_func, NULL, NULL, NULL);
+  assert(host);
+
+  Writes writes;
+  memset(&writes, 0, sizeof(writes));
+
+  SuilInstance* const instance = new_instance(host, &writes, ui_path);
+  assert(instance);
+
+  // Without coalescing, every write is forwarded immediately
+  write_control(instance, 3U, 1.0f);
+  write_control(instance, 3U, 2.0f);
+  assert(writes.n_writes == 2U);
+  assert(writes.values[1] == 2.0f);
+
+  suil_instance_free(instance);
+  suil_host_free(host);
+}
+
+int
+main(int argc, char** argv)
+{
+  assert(argc == 2);
+
+  test_coalesce(argv[1]);
+  test_flush_on_free(argv[1]);
+  test_disabled(argv[1]);
+  return 0;
+}